@@ -154,6 +154,7 @@ public:
     vec             getFieldP() { return vec(FPx,FPy,FPz); } // Only IOP
     void            setFieldP(double &fx, double &fy, double &fz) { FPx = fx; FPy = fy; FPz = fz; }
     vec             getFieldU() { return vec(FUx,FUy,FUz); } // Only IOP
+    void            setFieldU(double &fx, double &fy, double &fz) { FUx = fx; FUy = fy; FUz = fz; }
     vec             getU1() { return vec(U1x,U1y,U1z); }     // Only IOP
     void            setU1(vec &u1) { U1x = u1.getX(); U1y = u1.getY(); U1z = u1.getZ(); }
     // POTENTIALS
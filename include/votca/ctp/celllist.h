@@ -0,0 +1,71 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef VOTCA_CTP_CELLLIST_H
+#define	VOTCA_CTP_CELLLIST_H
+
+#include <votca/ctp/topology.h>
+#include <vector>
+
+namespace votca { namespace ctp {
+
+// Linked-cell binning of points for neighbour searches with a cut-off rc.
+// Cells are parallelepipeds spanned by the box vectors and at least rc wide
+// (perpendicular to each face), so every point within rc of point i - in
+// any periodic image - lies in the cells adjacent to that of i. This holds
+// for triclinic boxes as well as orthorhombic ones; for open boxes the grid
+// spans the bounding box of the points. Candidates() is a superset, callers
+// still apply the exact distance test.
+
+class CellList
+{
+public:
+
+    CellList() : _periodic(false) { _n[0] = _n[1] = _n[2] = 1; }
+   ~CellList() { ; }
+
+    void Build(Topology *top, const std::vector<double> &x,
+        const std::vector<double> &y, const std::vector<double> &z,
+        double rc);
+
+    // Appends the points in the cells around point i (i included) to nbs
+    void Candidates(int i, std::vector<int> &nbs) const;
+
+    int Cells() const { return _n[0]*_n[1]*_n[2]; }
+
+private:
+
+    // Neighbouring cell indices along axis k, no duplicates
+    int Adjacent(int k, int c, int *adj) const;
+
+    bool _periodic;
+    int _n[3];
+    vec _recip[3];                  // reciprocal box vectors (periodic)
+    double _lo[3];                  // bounding box (open)
+    double _hi[3];
+
+    std::vector<int> _cellOf;       // cell (ix, iy, iz) of each point
+    std::vector<int> _cellBegin;    // points of cell c are
+    std::vector<int> _points;       // _points[_cellBegin[c], [c+1])
+
+};
+
+}}
+
+#endif
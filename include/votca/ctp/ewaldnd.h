@@ -8,12 +8,46 @@
 #include <votca/ctp/xinteractor.h>
 #include <votca/ctp/xinductor.h>
 #include <votca/ctp/qmthread.h>
+#include <votca/tools/mutex.h>
 #include <boost/multi_array.hpp>
+#include <list>
 
 namespace CSG = votca::csg;
 
 namespace votca { namespace ctp {
     
+// Fields of the background (BGP, FGN correction) on the foreground sites.
+// Jobs with the same foreground, e.g. the n/e/h states of a segment, share
+// them: computed by the first job, copied by the others as long as the site
+// positions agree. Keeps up to 'capacity' foregrounds, most recent first.
+// NOTE The k-vector set is graded with the moments of the first job's FGC,
+//      hence the fields of other states agree to within the Ewald tolerance
+class EwdFieldCache
+{
+public:
+    EwdFieldCache() : _capacity(0) { ; }
+    void setCapacity(int capacity) { _capacity = capacity; }
+    // Set fields of fg from cache, false if not there (or positions differ)
+    bool Fetch(const string &key, vector<PolarSeg*> &fg, 
+        bool &converged_R, bool &converged_K);
+    void Store(const string &key, vector<PolarSeg*> &fg, 
+        bool converged_R, bool converged_K);
+private:
+    struct Fields
+    {
+        vector<vec> pos;
+        vector<vec> fp;
+        vector<vec> fu;
+        bool converged_R;
+        bool converged_K;
+    };
+    int                  _capacity;
+    map<string, Fields>  _fields;
+    std::list<string>    _lru;
+    votca::tools::Mutex  _lock;
+};
+
+
 // NOTE: This is not a conventional 3D Ewald summation, so use carefully
 //       (tuned for the purpose of cluster energy calculations)
 // NOTE: PolarTop should be set-up with three containers: FGC, FGN, BGN
@@ -46,6 +80,8 @@ public:
         vector<PolarSeg*> &ps1, vector<PolarSeg*> &ps2) { ; }
     
     // THOLEWALD EVALUATION
+    void setFieldCache(EwdFieldCache *cache, const string &key) 
+        { _field_cache = cache; _field_cache_key = key; }
     void Evaluate();
     void EvaluateFields(bool do_depolarize_fgc);
     void EvaluateInduction();    
@@ -209,6 +245,8 @@ protected:
     bool   _potential_converged_K;
     bool   _did_field_pin_R_shell;
     bool   _save_nblist;
+    EwdFieldCache *_field_cache;      // Background fields shared across jobs
+    string _field_cache_key;
     // Part II - Thole
     bool _polar_do_induce;
     double _polar_aDamp;
@@ -23,6 +23,7 @@
 #include <votca/ctp/atom.h>
 #include <votca/ctp/polarsite.h>
 #include <votca/ctp/apolarsite.h>
+#include <votca/ctp/nametable.h>
 #include <fstream>
 
 
@@ -44,7 +45,8 @@ class Segment;
 class Fragment {
 public:
 
-     Fragment(int id, string name) : _id(id), _name(name), _symmetry(-1) { }
+     Fragment(int id, string name) : _id(id), _name(name),
+         _nameId(NameTable::FragmentId(name)), _symmetry(-1) { }
      Fragment(Fragment *stencil);
     ~Fragment();
     
@@ -68,6 +70,7 @@ public:
 
     const int    &getId() const { return _id; }
     const string &getName() const { return _name; }
+    int           getNameId() const { return _nameId; }
 
     void         Rigidify(bool Auto = 0);
     void         setSymmetry(int sym) { _symmetry = sym; }
@@ -99,6 +102,7 @@ private:
 
     int         _id;
     string      _name;
+    int         _nameId;            // see NameTable
     Topology    *_top;
     Molecule    *_mol;
     int              _symmetry;
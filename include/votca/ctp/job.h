@@ -37,7 +37,8 @@ public:
     {
     public:
         
-        JobResult() { ; }
+        JobResult() : _has_walltime(false), _has_cputime(false), 
+            _has_rss(false), _phases("") { ; }
         
         void setStatus(JobStatus stat) { _status = stat; }
         void setStatus(string stat) { assert(false); }
@@ -46,22 +47,34 @@ public:
         void setOutput(Property &output)
             { _has_output = true; _output = output.get("output"); }
         void setError(string error) { _has_error = true; _error = error; }
+        void setWalltime(double sec) { _has_walltime = true; _walltime = sec; }
+        void setCputime(double sec) { _has_cputime = true; _cputime = sec; }
+        void setRss(long kb) { _has_rss = true; _rss = kb; }
+        void addPhase(string phase, double sec);
         
         JobStatus _status;
         Property _output;
         bool _has_output;
         string _error;
         bool _has_error;
+        double _walltime;
+        bool _has_walltime;
+        double _cputime;
+        bool _has_cputime;
+        long _rss;
+        bool _has_rss;
+        string _phases;
     };
 
     void Reset();
-    void ToStream(std::ofstream &ofs, string fileformat);
+    void ToStream(std::ostream &ofs, string fileformat);
     void UpdateFrom(Job *ext);
+    void UpdateFromRecord(Job *rec);
     void SaveResults(JobResult *res);
    
     int getId() const { return _id; }
     std::string getTag() const { return _tag; }
-    Property &getInput() { return _input; }    
+    Property &getInput();
     const JobStatus &getStatus() const { return _status; }
     string getStatusStr() const { return ConvertStatus(_status); }
     
@@ -69,6 +82,11 @@ public:
     bool hasTime() const { return _has_time; }
     bool hasOutput() const { return _has_output; }
     bool hasError() const { return _has_error; }
+    bool hasWalltime() const { return _has_walltime; }
+    bool hasCputime() const { return _has_cputime; }
+    bool hasRss() const { return _has_rss; }
+    bool hasPhases() const { return _phases != ""; }
+    bool hasCost() const { return _has_cost; }
     
     bool isAvailable() const { return (_status == AVAILABLE) ? true : false; }
     bool isAssigned() const { return (_status == ASSIGNED) ? true : false; }
@@ -80,12 +98,21 @@ public:
     void setStatus(string stat) { _status = ConvertStatus(stat); }
     void setTime(string time) { _time = time; _has_time = true; }
     void setHost(string host) { _host = host; _has_host = true; }
-    void setOutput(string output) { _output = Property().add("output", output); _has_output = true; }
+    void setError(string error) { _error = error; _has_error = true; }
+    void setOutput(string output) { _output = Property().add("output", output); _has_output = true; _has_output_xml = false; }
+    void setInputXml(const string &xml) { _inputXml = xml; _has_input_xml = true; }
+    void setOutputXml(const string &xml) { _outputXml = xml; _has_output_xml = true; _has_output = true; }
    
     const string &getHost() const { assert(_has_host); return _host; }
     const string &getTime() const { assert(_has_time); return _time; }
-    const Property &getOutput() const { assert(_has_output); return _output; }
+    const Property &getOutput() const;
     const string &getError() const { assert(_has_error); return _error; }
+    double getWalltime() const { assert(_has_walltime); return _walltime; }
+    double getCputime() const { assert(_has_cputime); return _cputime; }
+    long getRss() const { assert(_has_rss); return _rss; }
+    const string &getPhases() const { return _phases; }
+    double getCost() const { assert(_has_cost); return _cost; }
+    int getInputSize();
 
 protected:
 
@@ -97,17 +124,32 @@ protected:
      int _attemptsCount;
      Property _input;
      string _sqlcmd;
+     double _cost;
     
      // Generated during runtime
      string _host;
      bool   _has_host;
      string _time;
      bool   _has_time;
-     Property _output;
+     mutable Property _output;
      bool   _has_error;
      bool   _has_output;
      string _error;
      bool   _has_sqlcmd;
+     bool   _has_cost;
+     double _walltime;
+     bool   _has_walltime;
+     double _cputime;
+     bool   _has_cputime;
+     long   _rss;
+     bool   _has_rss;
+     string _phases;
+     
+     // Unparsed payloads (see JobReader)
+     string _inputXml;
+     bool   _has_input_xml;
+     mutable string _outputXml;
+     mutable bool   _has_output_xml;
 };
 
 
@@ -0,0 +1,54 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+#ifndef __VOTCA_CTP_JOBDATABASE_H
+#define	__VOTCA_CTP_JOBDATABASE_H
+
+#include <votca/tools/database.h>
+
+using namespace votca::tools;
+
+namespace votca { namespace ctp {
+
+/**
+ * \brief the job table
+ *
+ * Alternative to the XML job file of ctp_parallel (job_file=*.sql).
+ * Each job is one row, input and output are stored as XML text.
+ * Processes claim jobs row-wise inside an immediate transaction and
+ * report results per row, rather than rewriting the whole pool.
+ */
+class JobDatabase : public Database
+{
+public:
+    
+    /**
+     * \brief Create the database scheme
+     *
+     * This function is called when a database is created.
+     * All tables and triggers should be added here.
+     */
+    void onCreate();
+};
+
+}}
+
+#endif	/* __VOTCA_CTP_JOBDATABASE_H */
+
@@ -0,0 +1,57 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef VOTCA_CTP_JOBREADER_H
+#define	VOTCA_CTP_JOBREADER_H
+
+#include <votca/ctp/job.h>
+#include <votca/tools/property.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace votca { namespace ctp {
+
+using namespace std;
+using namespace votca::tools;
+
+// Streaming (SAX) reader for job files <jobs><job>...</job></jobs>: jobs are
+// built one at a time, no Property tree of the whole file. The <input> and
+// <output> payloads are kept as raw XML and only parsed by the job on first
+// access (see Job::getInput), i.e. never for jobs this process does not run.
+
+class JobReader
+{
+public:
+
+    JobReader() { ; }
+   ~JobReader() { ; }
+
+    void Read(const string &job_file, vector<Job*> &jobs);
+    void Read(std::istream &in, const string &name, vector<Job*> &jobs);
+
+    // Parses an XML fragment such as "<input>...</input>" into prop
+    static void PropertyFromXml(Property &prop, const string &xml,
+        const string &key);
+
+};
+
+}}
+
+#endif
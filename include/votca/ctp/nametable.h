@@ -0,0 +1,53 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef VOTCA_CTP_NAMETABLE_H
+#define	VOTCA_CTP_NAMETABLE_H
+
+#include <string>
+
+namespace votca { namespace ctp {
+
+// Process-wide interning of segment and fragment names to dense integer ids
+// 0, 1, 2, ... Segments and fragments look up their id once on construction
+// (Segment::getNameId, Fragment::getNameId); calculators map their options
+// to the same ids in Initialize and then index flat per-name (or per
+// name-pair) tables instead of string-keyed maps in their pair loops.
+// Ids are the same for all topologies and frames of a process.
+
+class NameTable
+{
+public:
+
+    // Id of name, a new one if the name has not been seen before
+    static int SegmentId(const std::string &name);
+    static int FragmentId(const std::string &name);
+
+    // Number of ids handed out so far
+    static int SegmentCount();
+    static int FragmentCount();
+
+    static std::string SegmentName(int id);
+    static std::string FragmentName(int id);
+
+};
+
+}}
+
+#endif
@@ -37,7 +37,14 @@ public:
 
     class PairOperator;
     
-    ParallelPairCalculator() : _nextPair(NULL) {};
+    // Next pair to hand out, one per evaluated frame
+    struct PairCursor {
+        QMNBList::iterator next;
+        QMNBList::iterator end;
+        Mutex              mutex;
+    };
+    
+    ParallelPairCalculator() : _fusedInto(NULL) {};
    ~ParallelPairCalculator() {};
 
     string       Identify() { return "Parallel pair calculator"; }
@@ -47,7 +54,15 @@ public:
     virtual void PostProcess(Topology *top) { ; }
     virtual void EvalPair(Topology *top, QMPair *qmpair, PairOperator* opThread) { ; }
 
-    QMPair     *RequestNextPair(int opId, Topology *top);
+    // Pair-local: EvalPair needs nothing but the pair (incl. its segments)
+    // and PostProcess leaves the pairs alone. Chained pair-local calculators
+    // are fused (AddStage) into one pass, each pair going through all of
+    // them while in cache.
+    virtual bool PairLocal() { return false; }
+    void         AddStage(ParallelPairCalculator *stage);
+    bool         isFused() { return _fusedInto != NULL; }
+
+    QMPair     *RequestNextPair(int opId, PairCursor *cursor);
     void         LockCout() { _coutMutex.Lock(); }
     void         UnlockCout() { _coutMutex.Unlock(); }
 
@@ -61,9 +76,10 @@ public:
     public:
 
         PairOperator(int id, Topology *top,
-                     ParallelPairCalculator *master)
+                     ParallelPairCalculator *master,
+                     PairCursor *cursor)
                    : _top(top), _pair(NULL),
-                     _master(master)      { _id = id; };
+                     _master(master), _cursor(cursor) { _id = id; };
 
        ~PairOperator() {};
 
@@ -75,14 +91,16 @@ public:
         Topology                *_top;
         QMPair                 *_pair;
         ParallelPairCalculator  *_master;
+        PairCursor              *_cursor;
     };
 
 
 protected:
 
-    QMNBList::iterator   _nextPair;
-    Mutex                 _nextPairMutex;
     Mutex                 _coutMutex;
+    
+    vector<ParallelPairCalculator*> _stages;
+    ParallelPairCalculator         *_fusedInto;
 
 
 };
@@ -7,6 +7,7 @@
 #include <votca/tools/mutex.h>
 #include <votca/ctp/job.h>
 #include <votca/ctp/progressobserver.h>
+#include <votca/ctp/subthreadpool.h>
 
 
 // PATHWAYS TO A NEW THREADED CALCULATOR
@@ -84,6 +85,7 @@ protected:
     Mutex                    _logMutex;
     string                   _jobfile;
     int                      _subthreads;
+    SubthreadPool            _subthreadPool;
     
     // ProgObserver< JobContainer, pJob > *_progObs;
 
@@ -3,12 +3,16 @@
 
 
 #include <vector>
+#include <deque>
 #include <iostream>
 #include <votca/tools/mutex.h>
 #include <votca/tools/property.h>
 #include <votca/ctp/job.h>
 #include <boost/interprocess/sync/file_lock.hpp>
 #include <boost/program_options.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 
 
 namespace votca { namespace ctp {
@@ -20,6 +24,46 @@ class QMThread;
 // REQUIRED METHODS FOR TYPENAMES
 //     pJob ->getId() ->SaveResults(rJob)
 //     JobContainer .size() .begin() .end()
+
+// JOB ORDER
+//     Jobs are handed out in file order, or with --order cost longest first
+//     (LPT) to cut the tail of a run. The estimate is, in this order of
+//     preference: the wall time recorded for the job, a <cost> hint in the
+//     job file, the mean wall time of its tag, the size of its input.
+
+// CACHE SIZE
+//     Fixed (--cache), or with --sync-interval adapted at every sync: enough
+//     jobs to last that many seconds at the measured throughput, but never
+//     more than a share of the jobs left (guided self-scheduling), so that
+//     lock traffic stays bounded and no host hoards work at the end.
+
+// JOB JOURNAL
+//     Status changes (ASSIGNED, COMPLETE, FAILED) are appended as records to
+//     a journal next to the job file, e.g. jobs.xml => jobs.journal. A sync
+//     replays only records appended since the last sync. The journal is
+//     compacted into the job file (+ .tab) once it has grown to a fraction
+//     of the job count, and whenever a process runs out of jobs.
+
+// JOB TABLE
+//     With a job file *.sql, jobs are kept in an SQLite table instead (see 
+//     JobDatabase). Jobs are claimed row-wise (CLAIM_JOBS), results are
+//     written per row on report; no file lock, no journal. A missing table
+//     is created from the *.xml job file of the same name.
+
+// JOB SERVER
+//     With --serve, one process owns the jobs in memory and hands them out to
+//     local workers over a Unix socket next to the job file (jobs.xml =>
+//     jobs.sock). Workers that find the socket request jobs and report 
+//     results via SYNC messages instead of locking the job file; without a
+//     server they fall back to the file lock. The server holds the file lock
+//     for the whole session and keeps the journal, compacted as above.
+
+// ASYNC I/O
+//     With --async-io, syncs run on a dedicated I/O thread instead of on the
+//     job thread that found the cache empty. Job threads pop jobs from and
+//     push results to in-memory queues only; once no more jobs are queued
+//     than there are job threads, the I/O thread fetches the next batch and
+//     flushes the results reported so far in the same sync.
     
 template<typename JobContainer, typename pJob, typename rJob>
 class ProgObserver 
@@ -30,9 +74,18 @@ public:
     typedef typename JobContainer::iterator JobItCnt;
     typedef typename vector<pJob>::iterator JobItVec;
     
+    class IOThread;
+    
     ProgObserver()
         : _lockFile("__NOFILE__"), _progFile("__NOFILE__"), _cacheSize(-1),
-          _nextjit(NULL), _metajit(NULL), _startJobsCount(0) { ; }
+          _nextjit(NULL), _metajit(NULL), _sqlJobs(false), _jobsCount(0),
+          _serve(false), _report(false), _sockFile("__NOFILE__"), _sockFd(-1), _nClients(0),
+          _order("file"), _syncInterval(0.0), _nThreads(1), _jobRate(0.0),
+          _lastReported(0), _jobsAvailable(0), _asyncIO(false), _ioThread(NULL),
+          _ioRequested(false), _ioStop(false), _ioDry(false),
+          _journalFile("__NOFILE__"),
+          _journalOffset(0), _journalRecords(0), _jobsReported(0),
+          _startJobsCount(0) { ; }
     
    ~ProgObserver() { ; }
     
@@ -42,9 +95,30 @@ public:
     void ReportJobDone(pJob job, rJob *res, QMThread *thread);
     
     void SyncWithProgFile(QMThread *thread);
+    void SyncWithJobTable(QMThread *thread);
+    void SyncWithServer(QMThread *thread);
+    void AssignJobs(vector<pJob> &assigned, int n, string thisHost);
+    bool isRestart(pJob job);
+    void CountJobs();
+    void OrderJobsByCost(QMThread *thread);
+    int  AdaptCacheSize(int remaining, int hosts, QMThread *thread);
+    void StartIOThread(QMThread *thread);
+    void StopIOThread(QMThread *thread);
+    void RunIOThread(QMThread *thread);
+    void CompactProgFile(QMThread *thread);
     void LockProgFile(QMThread *thread);
     void ReleaseProgFile(QMThread *thread);
     
+    bool isServer() { return _serve; }
+    bool isReport() { return _report; }
+    void WriteReport(QMThread *thread);
+    void Serve(QMThread *thread);
+    string ServeRequest(const string &request, QMThread *thread);
+    bool ConnectToServer(QMThread *thread);
+    
+    void StartJournal(QMThread *thread);
+    void ReadJournalHeader(const string &journal, string &epoch, string &prev);
+    
     string GenerateHost(QMThread *thread);
     string GenerateTime();
    
@@ -64,6 +138,41 @@ private:
     Mutex _lockThread;
     boost::interprocess::file_lock *_flock;
     
+    bool _sqlJobs;
+    int _jobsCount;
+    
+    bool _serve;
+    bool _report;
+    string _sockFile;
+    int _sockFd;
+    int _nClients;
+    
+    string _order;
+    JobContainer _jobOrder;
+    
+    double _syncInterval;
+    int _nThreads;
+    double _jobRate;
+    int _lastReported;
+    boost::posix_time::ptime _lastSyncTime;
+    int _jobsAvailable;
+    map<string,int> _hostJobs;
+    
+    bool _asyncIO;
+    IOThread *_ioThread;
+    boost::mutex _ioMutex;
+    boost::condition_variable _ioCond;
+    std::deque<pJob> _jobsReady;
+    vector<pJob> _jobsDone;
+    bool _ioRequested;
+    bool _ioStop;
+    bool _ioDry;
+    
+    string _journalFile;
+    string _journalEpoch;
+    long _journalOffset;
+    int _journalRecords;
+    
     map<string,bool> _restart_hosts;
     map<string,bool> _restart_stats;
     bool _restartMode;
@@ -84,8 +193,29 @@ JobContainer LOAD_JOBS(const string &xml_file);
 template<typename JobContainer, typename pJob, typename rJob>
 void WRITE_JOBS(JobContainer &jobs, const string &job_file, string fileformat);
 
+template<typename JobContainer, typename pJob, typename rJob>
+void REPORT_JOBS(JobContainer &jobs, const string &job_file);
+
 template<typename JobContainer, typename pJob, typename rJob>
 void UPDATE_JOBS(JobContainer &from, JobContainer &to, string thisHost);
+
+template<typename JobContainer, typename pJob, typename rJob>
+JobContainer CLAIM_JOBS(const string &job_file, int n, string thisHost, 
+    string time);
+
+template<typename JobContainer, typename pJob, typename rJob>
+void COUNT_JOBS(const string &job_file, string thisHost, int &available, 
+    int &hosts);
+
+template<typename JobContainer, typename pJob, typename rJob>
+void APPEND_JOBS(vector<pJob> &jobs, const string &journal_file);
+
+template<typename JobContainer, typename pJob, typename rJob>
+void TALLY_JOB(pJob job, int sign, int &available, map<string,int> &hosts);
+
+template<typename JobContainer, typename pJob, typename rJob>
+int REPLAY_JOBS(JobContainer &jobs, const string &journal_file, long &offset, 
+    string thisHost, int &available, map<string,int> &hosts);
     
     
     
@@ -42,6 +42,13 @@ public:
     virtual void    Initialize(Property *options) = 0;
     virtual bool    EvaluateFrame(CTP::Topology *top) { return true; }
     virtual void    EndEvaluate(CTP::Topology *top) { }
+    
+    // Parts of the topology read or written (TopologyPart flags)
+    virtual int     TopologyParts() { return TOP_ALL; }
+    
+    // Whether frames may be evaluated concurrently (--frame-threads): no
+    // state carried from frame to frame, no shared output files
+    virtual bool    FrameIndependent() { return false; }
 
 protected:
 
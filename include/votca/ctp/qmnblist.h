@@ -25,6 +25,7 @@
 #include <stdlib.h>
 #include <votca/csg/pairlist.h>
 #include <votca/ctp/qmpair.h>
+#include <unordered_map>
 
 namespace CSG = votca::csg;
 
@@ -82,6 +83,10 @@ public:
             return segment_type == donor || segment_type == acceptor ;
         }
 
+        bool bridgesDonorAcceptor() {
+            return isOfBridge(donor) || isOfBridge(acceptor);
+        }
+
 	std::string asString() {
 	    std::string ts;
             ts += donor;
@@ -99,13 +104,7 @@ public:
 
     QMNBList() : _top(NULL), _cutoff(0) { };
     QMNBList(Topology* top) : _top(top), _cutoff(0) { };
-   ~QMNBList() { 
-       CSG::PairList<Segment*, QMPair>::Cleanup();       
-       // cleanup the list of superexchange pairs
-       for ( std::list<SuperExchangeType*>::iterator it = _superexchange.begin() ; it != _superexchange.end(); it++  ) {
-           delete *it;
-       }
-   }
+   ~QMNBList() { this->Cleanup(); }
     
    /**
     * \brief Adds SuperExchange pairs to the neighbor list 
@@ -117,15 +116,21 @@ public:
     * The BRIDGED pairs are stored but BRIDGING pairs have to be regenerated every time 
     * we need them (edft job writer, idft job writer and importer)
     * 
+    * Candidates are collected per bridge segment on nThreads threads, then
+    * merged in segment order: the result does not depend on nThreads.
+    * 
     */
-    void GenerateSuperExchange();
+    void GenerateSuperExchange(int nThreads = 1);
     
     /**
      * @param type Adds a SuperExchangeType based on this string (Donor Bridge1 Bridge2 ... Acceptor)
      */
     void AddSuperExchangeType(std::string type) { _superexchange.push_back(new SuperExchangeType(type)); }
     
-    void setSuperExchangeTypes(std::list<SuperExchangeType*> types) { _superexchange = types; }
+    /**
+     * @param types Replaces (and deletes) the current types, the list takes ownership
+     */
+    void setSuperExchangeTypes(std::list<SuperExchangeType*> types);
     
     const std::list<SuperExchangeType*> &getSuperExchangeTypes() const { return _superexchange; }
 
@@ -134,6 +139,12 @@ public:
 
     QMPair *Add(Segment* seg1, Segment* seg2,bool safe=true);
 
+    // Hash lookup of a pair, in either order; NULL if there is none
+    QMPair *FindPair(Segment* seg1, Segment* seg2);
+
+    // Deletes pairs and superexchange types: both are read or generated per frame
+    void Cleanup();
+
     void PrintInfo(std::FILE *out);
     
     void AddQMNBlist(QMNBList &temp);
@@ -143,6 +154,17 @@ protected:
     Topology   *_top;
     double      _cutoff;
     std::list<SuperExchangeType*> _superexchange;
+
+    // Pair index keyed by the (address-ordered) segment pair
+    struct SegmentPairHash {
+        size_t operator()(const std::pair<Segment*, Segment*> &p) const {
+            size_t h1 = std::hash<Segment*>()(p.first);
+            size_t h2 = std::hash<Segment*>()(p.second);
+            return h1 ^ (h2 + 0x9e3779b9 + (h1 << 6) + (h1 >> 2));
+        }
+    };
+    std::unordered_map< std::pair<Segment*, Segment*>, QMPair*, 
+        SegmentPairHash > _pairIndex;
 };
 
 
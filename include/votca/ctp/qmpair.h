@@ -69,7 +69,8 @@ public:
                 _lambdaO_t(0),   
                 _Jeff2_s(0),
                 _Jeff2_t(0),
-                _pair_type(Hopping) { };
+                _pair_type(Hopping),
+                _dirty(DIRTY_ALL) { };
     QMPair(int id, Segment *seg1, Segment *seg2);
    ~QMPair();
 
@@ -121,12 +122,18 @@ public:
    void     WriteXYZ(std::FILE *out, bool useQMPos = true);
 
    // superexchange pairs have a list of bridging segments
-   void     setType( PairType pair_type ) { _pair_type = pair_type; }
-   void     setType( int pair_type ) { _pair_type = (PairType) pair_type; }
+   void     setType( PairType pair_type ) { _pair_type = pair_type; _dirty |= DIRTY_TYPE; }
+   void     setType( int pair_type ) { _pair_type = (PairType) pair_type; _dirty |= DIRTY_TYPE; }
    void     AddBridgingSegment( Segment* _segment ){ _bridging_segments.push_back(_segment); }
    const std::vector<Segment*> &getBridgingSegments() const { return _bridging_segments; }
    PairType &getType(){return _pair_type;}
 
+   // Column groups set since the last read/save, see StateSaverSQLite
+   enum Dirty { DIRTY_CARRIERS = 1, DIRTY_LAMBDA = 2, DIRTY_RATES = 4,
+                DIRTY_JEFF2 = 8, DIRTY_TYPE = 16, DIRTY_ALL = 31 };
+   int      getDirty() { return _dirty; }
+   void     setClean() { _dirty = 0; }
+
 protected:
 
     vec         _R;
@@ -164,6 +171,7 @@ protected:
     double          _Jeff2_t;
 
     PairType _pair_type;
+    int      _dirty;
     std::vector<Segment*> _bridging_segments;
 
 
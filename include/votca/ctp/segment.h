@@ -26,6 +26,7 @@
 #include <votca/ctp/atom.h>
 #include <votca/ctp/polarsite.h>
 #include <votca/ctp/apolarsite.h>
+#include <votca/ctp/nametable.h>
 
 class Topology;
 
@@ -44,6 +45,7 @@ public:
 
     const int       &getId() { return _id; }
     const std::string    &getName() { return _name; }
+    int              getNameId() const { return _nameId; }
 
     const vec       &getPos() const { return _CoM; }
     void             setPos(vec pos) { _CoM = pos; }
@@ -99,6 +101,15 @@ public:
 
     void Rigidify();
 
+    // Column groups set since the last read/save, see StateSaverSQLite
+    enum Dirty { DIRTY_U = 1, DIRTY_EMPOLES = 2, DIRTY_OCC = 4, 
+                 DIRTY_STATES = 8, DIRTY_ALL = 15 };
+    int              getDirty() { return _dirty; }
+    void             setClean() { _dirty = 0; }
+    // Drops the state a frame leaves behind, before a frame is read into
+    // the same segment (StateSaverSQLite, reuse mode)
+    void             ResetState();
+
     void WritePDB(std::FILE *out, std::string tag1 = "Fragments", std::string tag2 = "MD");
     void WriteXYZ(std::FILE *out, bool useQMPos = true);
 
@@ -106,6 +117,8 @@ private:
 
     int         _id;
     std::string      _name;
+    int         _nameId;        // see NameTable
+    int         _dirty;
     SegmentType *_typ;
     Topology    *_top;
     Molecule    *_mol;
@@ -42,6 +42,7 @@ public:
 
    virtual void BeginEvaluate(int nThreads);
    virtual bool EvaluateFrame();
+   virtual bool EvaluateFrame(Topology *top);
    virtual void EndEvaluate();
 
    void AddCalculator(QMCalculator *calculator);
@@ -34,12 +34,17 @@ using namespace votca::tools;
 class StateSaverSQLite
 {
 public:
-    StateSaverSQLite() { };
+    StateSaverSQLite() : _parts(TOP_ALL), _snapshots(false), _wal(-1),
+        _walActive(false), _reuse(false), _flock(NULL) { };
    ~StateSaverSQLite() { _db.Close(); }
 
     void Open(Topology &qmtop, const string &file, bool lock = true);
+    // Journal mode set on Open and stored in the file: 1 = WAL (concurrent
+    // readers, local file systems only), 0 = rollback journal, -1 = as is
+    void setWAL(int wal) { _wal = wal; }
     void Close() { _db.Close(); }
     bool NextFrame();
+    void setTopology(Topology &qmtop) { _qmtop = &qmtop; }
 
     void WriteFrame();
     void WriteMeta(bool update);
@@ -50,8 +55,22 @@ public:
     void WriteAtoms(bool update);
     void WritePairs(bool update);
     void WriteSuperExchange(bool update);
+    void UpdateSegments();
+    void UpdatePairs();
+
+    // Only load (and save back) these parts of each frame
+    void setParts(int parts);
+    int  getParts() { return _parts; }
+
+    // Read frames from binary snapshots (see TopologySnapshot) where they
+    // are up to date, (re)write them from fully loaded or saved frames
+    void setSnapshots(bool yesno) { _snapshots = yesno; }
+    string SnapshotFile(int topId);
+    string StateStamp();
+    int    StateGeneration();
 
     void ReadFrame();
+    void ReadParts(int topId);
     void ReadMeta(int topId);
     void ReadMolecules(int topId);
     void ReadSegTypes(int topId);
@@ -65,7 +84,9 @@ public:
     Topology *getTopology() { return _qmtop; }
     bool HasTopology(Topology *top);
     
-    void LockStateFile();
+    // Shared for reading, exclusive for the write transaction, on the
+    // separate <state>.lock. No-op under WAL: SQLite handles concurrency.
+    void LockStateFile(bool exclusive = true);
     void UnlockStateFile();
     
 private:
@@ -79,8 +100,18 @@ private:
 
     string          _sqlfile;
     bool            _was_read;
+    int             _parts;
+    bool            _snapshots;
+    int             _wal;
+    bool            _walActive;
+    
+    // Frame read into the objects of the previous one (same composition),
+    // a mismatching row throws CompositionChanged => full read
+    struct CompositionChanged { };
+    bool            _reuse;
     
     boost::interprocess::file_lock *_flock;
+    bool            _flockShared;
 };
 
 }}
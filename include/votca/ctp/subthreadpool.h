@@ -0,0 +1,71 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef _CTP_SUBTHREADPOOL_H
+#define	_CTP_SUBTHREADPOOL_H
+
+#include <votca/tools/mutex.h>
+
+namespace votca { namespace ctp {
+
+using namespace votca::tools;
+
+// Cores given up by job threads that ran out of jobs. Jobs still running
+// claim a share of these as extra subthreads and return them when done.
+// Donate/Claim/Return only move counts, no thread is handed over as such.
+
+class SubthreadPool
+{
+public:
+
+    SubthreadPool() : _idle(0), _busy(0) { ; }
+   ~SubthreadPool() { ; }
+
+    void Reset() {
+        _mutex.Lock(); _idle = 0; _busy = 0; _mutex.Unlock();
+    }
+
+    void BeginJob() { _mutex.Lock(); _busy += 1; _mutex.Unlock(); }
+    void EndJob() { _mutex.Lock(); _busy -= 1; _mutex.Unlock(); }
+
+    // Calling thread will not take further jobs, its core is up for grabs
+    void Donate() { _mutex.Lock(); _idle += 1; _mutex.Unlock(); }
+
+    // Fair share of idle cores across running jobs (at least one if any)
+    int Claim() {
+        _mutex.Lock();
+        int share = (_busy > 1) ? _idle / _busy : _idle;
+        if (share == 0 && _idle > 0) share = 1;
+        _idle -= share;
+        _mutex.Unlock();
+        return share;
+    }
+
+    void Return(int n) { _mutex.Lock(); _idle += n; _mutex.Unlock(); }
+
+private:
+
+    Mutex _mutex;
+    int   _idle;
+    int   _busy;
+};
+
+}}
+
+#endif
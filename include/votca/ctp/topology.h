@@ -22,6 +22,7 @@
 #define	__VOTCA_CTP_TOPOLOGY_H
 
 #include <votca/tools/property.h>
+#include <votca/tools/mutex.h>
 
 #include <votca/csg/boundarycondition.h>
 #include <votca/csg/openbox.h>
@@ -38,6 +39,7 @@
 
 #include <votca/ctp/qmpair.h>
 #include <votca/ctp/qmnblist.h>
+#include <votca/ctp/topologyarrays.h>
 
 //#include <votca/moo/jcalc.h>
 //#include <votca/moo/mol_and_orb.h>
@@ -47,6 +49,19 @@ namespace CSG = votca::csg;
 
 namespace votca { namespace ctp {
 
+// Parts of a topology as stored in the state file. Calculators declare the
+// parts they use (QMCalculator::TopologyParts), only these are loaded.
+enum TopologyPart {
+    TOP_MOLECULES     = 1 << 0,
+    TOP_SEGTYPES      = 1 << 1,
+    TOP_SEGMENTS      = 1 << 2,
+    TOP_FRAGMENTS     = 1 << 3,
+    TOP_ATOMS         = 1 << 4,
+    TOP_PAIRS         = 1 << 5,
+    TOP_SUPEREXCHANGE = 1 << 6,
+    TOP_ALL           = (1 << 7) - 1
+};
+
 /**
  * \brief Container for molecules, conjugated segments, rigid fragments,
  * and atoms.
@@ -85,6 +100,10 @@ public:
     vector< APolarSite* >   &APolarSites() { return _apolarSites; }
     vector< SegmentType* >  &SegmentTypes() { return _segmentTypes; }
 
+    // Segments, fragments as flat arrays (lazily rebuilt, thread-safe)
+    const TopologyArrays &Arrays();
+    void                InvalidateArrays() { _arraysValid = false; }
+
     bool                Rigidify();
     void                setCanRigidify(bool yesno) { _canRigidify = yesno; }
     const bool         &canRigidify() { return _canRigidify; }
@@ -99,6 +118,9 @@ public:
     vec              PbShortestConnect(const vec &r1, const vec &r2) const;
     const matrix    &getBox() { return _bc->getBox(); }
     double           BoxVolume() { return _bc->BoxVolume(); }
+    CSG::BoundaryCondition::eBoxtype getBoxType() {
+        return (_bc) ? _bc->getBoxType() : CSG::BoundaryCondition::typeOpen;
+    }
     void             setBox(const matrix &box,
                             CSG::BoundaryCondition::eBoxtype boxtype =
                             CSG::BoundaryCondition::typeAuto);
@@ -115,6 +137,9 @@ public:
     int              getDatabaseId() { return _db_id; };
     void             setDatabaseId(int id) { _db_id = id; }
     void             CleanUp();
+    // Next frame has the same composition: keep molecules, segments, 
+    // fragments, atoms (their properties are overwritten), drop the rest
+    void             ResetFrame();
 
     void             PrintInfo(ostream &out);
     void             PrintInfo(FILE *out);
@@ -144,6 +169,10 @@ protected:
     double _time;
     int    _step;
 
+    TopologyArrays          _arrays;
+    bool                    _arraysValid;
+    votca::tools::Mutex     _arraysMutex;
+
 
     CSG::BoundaryCondition::eBoxtype
     AutoDetectBoxType(const matrix &box);
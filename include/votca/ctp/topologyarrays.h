@@ -0,0 +1,64 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef VOTCA_CTP_TOPOLOGYARRAYS_H
+#define	VOTCA_CTP_TOPOLOGYARRAYS_H
+
+#include <vector>
+
+namespace votca { namespace ctp {
+
+class Segment;
+class Fragment;
+
+// Structure-of-arrays view of segments and fragments for geometric sweeps
+// (distance kernels etc.): contiguous coordinates instead of pointer chasing.
+// Built by Topology::Arrays() on first use after a frame load or Rigidify.
+// Values are those at build time, call Topology::InvalidateArrays() after
+// moving segments.
+
+struct TopologyArrays
+{
+    // Segments, index = segment id - 1
+    std::vector<double>     segX, segY, segZ;
+    std::vector<int>        segType;        // segment type id, 0 if none
+    std::vector<int>        segName;        // NameTable segment id
+    std::vector<int>        segFragBegin;   // fragments of segment i are
+                                            // [segFragBegin[i], [i+1])
+    std::vector<Segment*>   segments;
+
+    // Fragments, grouped by segment
+    std::vector<double>     fragX, fragY, fragZ;
+    std::vector<int>        fragSeg;        // index of the segment
+    std::vector<int>        fragName;       // NameTable fragment id
+    std::vector<Fragment*>  fragments;
+
+    void clear() {
+        segX.clear(); segY.clear(); segZ.clear(); segType.clear(); segName.clear();
+        segFragBegin.clear();
+        segments.clear();
+        fragX.clear(); fragY.clear(); fragZ.clear(); fragSeg.clear();
+        fragName.clear();
+        fragments.clear();
+    }
+};
+
+}}
+
+#endif
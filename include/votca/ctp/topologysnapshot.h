@@ -0,0 +1,57 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef VOTCA_CTP_TOPOLOGYSNAPSHOT_H
+#define	VOTCA_CTP_TOPOLOGYSNAPSHOT_H
+
+#include <votca/ctp/topology.h>
+#include <string>
+
+namespace votca { namespace ctp {
+
+using namespace std;
+
+// Binary snapshot (*.ctpbin) of one frame of the state file: a header with
+// section offsets, then flat, 8-byte aligned arrays of fixed-size records
+// for molecules, segment types, segments, fragments, atoms, pairs and
+// super-exchange types. Names are indices into one interned string table.
+// The file is mapped into memory and the topology built straight from the
+// records, no SQL, no per-row parsing.
+//
+// The state file stays the canonical store: each snapshot carries the stamp
+// (write generation, size and modification time of the state file and its
+// WAL) it was taken from and is ignored once these have changed, see
+// StateSaverSQLite.
+
+class TopologySnapshot
+{
+public:
+
+    // Writes via a temporary file + rename, readers never see partial files
+    static void Write(Topology &top, const string &file, const string &stamp);
+
+    // Builds top (expected to be empty) from file, false if there is no
+    // snapshot or it was taken from another version of the state file
+    static bool Read(Topology &top, const string &file, const string &stamp);
+
+};
+
+}}
+
+#endif
@@ -24,6 +24,7 @@
 #include <votca/ctp/xinteractor.h>
 #include <votca/ctp/xjob.h>
 #include <votca/ctp/logger.h>
+#include <votca/ctp/subthreadpool.h>
 #include <votca/tools/thread.h>
 #include <votca/tools/mutex.h>
 
@@ -47,7 +48,9 @@ public:
               _wSOR_N(0.5),        _wSOR_C(0.5),
               _epsTol(0.001),      _maxIter(512),
               _maverick(true),     _top(NULL),
-              _aDamp(0.390)
+              _aDamp(0.390),       _pool(NULL),
+              _claimed(0),         _t_indu(0.0),
+              _t_ener(0.0)
             { _actor = XInteractor(NULL, _aDamp); };
     
     XInductor(bool induce,   bool induce_intra_pair, int subthreads,
@@ -58,7 +61,9 @@ public:
               _subthreads(subthreads), _wSOR_N(wSOR_N),     _wSOR_C(wSOR_C),   
               _epsTol(epsTol),         _maxIter(maxIter),
               _maverick(maverick),     _top(top),
-              _aDamp(aDamp)
+              _aDamp(aDamp),           _pool(NULL),
+              _claimed(0),             _t_indu(0.0),
+              _t_ener(0.0)
             { _actor = XInteractor(top, _aDamp); };
             
     XInductor(Topology *top, Property *opt, string sfx, int nst, bool mav);
@@ -300,6 +305,38 @@ public:
     // Manage Subthreads           //
     // +++++++++++++++++++++++++++ //
     
+    void        ClaimSubthreads() {
+        // Grow worker team by cores that job threads gave up on
+        if (_pool == NULL) return;
+        int extra = _pool->Claim();
+        if (extra == 0) return;
+        for (int id = 0; id < extra; ++id) {
+            InduWorker *newIndu = new InduWorker(_indus.size(), _top, this);
+            _indus.push_back(newIndu);
+            newIndu->InitSpheres(&_qmm, &_mm2);
+            newIndu->SetSwitch(1);
+        }
+        _subthreads += extra;
+        _claimed += extra;
+        this->InitChunks();
+        CTP_LOG(logDEBUG,*_log) << "Inductor: Claimed " << extra 
+            << " donated subthreads, NST = " << _subthreads << flush;
+    }
+    
+    void        ReturnSubthreads() {
+        // Shrink worker team back to its own size, Configure and the next
+        // Evaluate start from there
+        if (_pool == NULL || _claimed == 0) return;
+        for (int id = 0; id < _claimed; ++id) {
+            delete _indus.back();
+            _indus.pop_back();
+        }
+        _subthreads -= _claimed;
+        _pool->Return(_claimed);
+        _claimed = 0;
+        this->InitChunks();
+    }
+    
     void        ClearTodoTable() {
         for (unsigned int i = 0; i < _xy_done.size(); ++i) {
         for (unsigned int j = 0; j < _xy_done[i].size(); ++j) {
@@ -474,10 +511,13 @@ public:
     double      EnergyStatic(XJob *job);    
     
     void        setLog(Logger *log) { _log = log; }
+    void        setSubthreadPool(SubthreadPool *pool) { _pool = pool; }
     
     bool        hasConverged() { return (_induce) ? _isConverged : true; }
     void        setError(string error) { _error = error; }
     string      getError() { return _error; }
+    double      getTimeInduction() { return _t_indu; }
+    double      getTimeEnergy() { return _t_ener; }
     
 private:    
     
@@ -519,6 +559,12 @@ private:
     vector< vector<int> >         _nx2;
     vector< vector<int> >         _ny1;
     vector< vector<int> >         _ny2;
+    // Cores donated by idle job threads
+    SubthreadPool                *_pool;
+    int                           _claimed;
+    // Wall times of last evaluation [s]
+    double                        _t_indu;
+    double                        _t_ener;
 
 };  
     
@@ -23,6 +23,8 @@
 #include <votca/ctp/xjob.h>
 #include <votca/ctp/apolarsite.h>
 #include <votca/ctp/qmthread.h>
+#include <boost/shared_ptr.hpp>
+#include <list>
 
 // TODO Change maps to _alloc_xmlfile_fragsegmol_***
 // TODO Confirm thread safety
@@ -35,7 +37,8 @@ class XMpsMap
 
 public:        
 
-    XMpsMap() : _alloc_table("no_alloc"), _estatics_only(false) {};
+    XMpsMap() : _alloc_table("no_alloc"), _estatics_only(false),
+        _env_capacity(0) {};
    ~XMpsMap() {};
 
     // User interface:
@@ -52,6 +55,12 @@ public:
     
     void setEstaticsOnly(bool estatics_only) { _estatics_only = estatics_only; }
     
+    // Environment of a job = all but its charged foreground (FGN+BGN, MM1+MM2,
+    // loaded background). Shared by jobs with the same foreground, e.g. the
+    // n/e/h states of a segment: mapped once, copied per job. Keeps up to
+    // 'capacity' environments, 0 = map per job.
+    void setShareEnv(int capacity) { _env_capacity = capacity; }
+    
     // Called by GenerateMap(...)
     void CollectMapFromXML(string xml_file);
     void CollectSegMpsAlloc(string alloc_table, Topology *top);
@@ -80,6 +89,46 @@ private:
     // Raw polar sites collected from mps-files
     map<string,vector<APolarSite*> > _mpsFile_pSites;
     map<string,vector<APolarSite*> > _mpsFile_pSites_job;
+    
+    // Shared environments, most recently used first
+    class XEnv
+    {
+    public:
+        XEnv(const string &k) : key(k), ready(false) { ; }
+       ~XEnv();
+        string key;
+        bool ready;                // Set by ::FillEnv
+        vector<PolarSeg*> inner;   // FGN or MM1
+        vector<PolarSeg*> outer;   // BGN or MM2
+        vector<Segment*> segs_inner;
+        vector<Segment*> segs_outer;
+        votca::tools::Mutex mapped; // Held while being mapped
+    };
+    typedef boost::shared_ptr<XEnv> XEnvPtr;
+    
+    // Held by the thread that maps an environment: if mapping throws before
+    // ::FillEnv, drops the environment again and releases waiting threads
+    class XEnvGuard
+    {
+    public:
+        XEnvGuard(XMpsMap *xmap, XEnvPtr env, bool do_map) 
+            : _xmap(xmap), _env(do_map ? env : XEnvPtr()) { ; }
+       ~XEnvGuard() { if (_env && !_env->ready) _xmap->DropEnv(_env); }
+    private:
+        XMpsMap *_xmap;
+        XEnvPtr _env;
+    };
+    
+    XEnvPtr RequestEnv(const string &key, bool &do_map);
+    void    FillEnv(XEnvPtr env, vector<PolarSeg*> &inner, 
+        vector<PolarSeg*> &outer, vector<Segment*> &segs_inner, 
+        vector<Segment*> &segs_outer);
+    void    DropEnv(XEnvPtr env);
+    void    CopyPolarSegs(vector<PolarSeg*> &from, vector<PolarSeg*> &to);
+    
+    int                              _env_capacity;
+    map<string, XEnvPtr>             _env;
+    std::list<string>                _env_lru;
 };
     
     
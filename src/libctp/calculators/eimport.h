@@ -17,6 +17,7 @@ public:
 
    void Initialize(Property *options);
    bool EvaluateFrame(Topology *top);
+   int  TopologyParts() { return TOP_SEGMENTS; }
 
 private:
 
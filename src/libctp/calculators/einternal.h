@@ -37,6 +37,8 @@ public:
     void Initialize(Property *options);
     void ParseEnergiesXML(Property *options);
     bool EvaluateFrame(Topology *top);
+    int  TopologyParts() { return TOP_SEGMENTS; }
+    bool FrameIndependent() { return true; }
 
 private:
 
@@ -195,11 +197,12 @@ bool EInternal::EvaluateFrame(Topology *top) {
 
         ++count;
 
-        if (_seg_has_e[segName]) {
+        // Lookups must not insert: frames may be evaluated concurrently
+        if (_seg_has_e.count(segName) && _seg_has_e.at(segName)) {
 
-            double u  = _seg_U_cC_nN_e[segName];
-            double l1 = _seg_U_nC_nN_e[segName];
-            double l2 = _seg_U_cN_cC_e[segName];
+            double u  = _seg_U_cC_nN_e.at(segName);
+            double l1 = _seg_U_nC_nN_e.at(segName);
+            double l2 = _seg_U_cN_cC_e.at(segName);
             bool has_e = true;
 
             (*sit)->setU_cC_nN(u, -1);
@@ -208,11 +211,11 @@ bool EInternal::EvaluateFrame(Topology *top) {
             (*sit)->setHasState(has_e, -1);
         }
 
-        if (_seg_has_h[segName]) {
+        if (_seg_has_h.count(segName) && _seg_has_h.at(segName)) {
 
-            double u  = _seg_U_cC_nN_h[segName];
-            double l1 = _seg_U_nC_nN_h[segName];
-            double l2 = _seg_U_cN_cC_h[segName];
+            double u  = _seg_U_cC_nN_h.at(segName);
+            double l1 = _seg_U_nC_nN_h.at(segName);
+            double l2 = _seg_U_cN_cC_h.at(segName);
             bool has_h = true;
 
             (*sit)->setU_cC_nN(u, +1);
@@ -34,6 +34,7 @@ public:
 
     void    Initialize(Property *options);
     bool    EvaluateFrame(Topology *top);
+    int     TopologyParts() { return TOP_SEGMENTS | TOP_PAIRS; }
     void    IHist(Topology *top, int state);
 
 private:
@@ -35,6 +35,7 @@ public:
 
     void        Initialize(Property *options);
     bool        EvaluateFrame(Topology *top);
+    int         TopologyParts() { return TOP_SEGMENTS | TOP_PAIRS | TOP_SUPEREXCHANGE; }
     void        XML2PairTI(QMPair *qmpair, string &xmlDirFile);
     void        List2PairsTI(Topology *top, string &ti_file);
     void        FromIDFT(Topology *top, string &_idft_jobs_file);
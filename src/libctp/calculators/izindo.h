@@ -51,6 +51,7 @@ public:
     void    Initialize(Property *options);
     void    ParseOrbitalsXML(Property *options);
     void    EvalPair(Topology *top, QMPair *pair, PairOperator *opThread);
+    bool    PairLocal() { return true; }
 
     void    CTP2MOO2CTP(QMPair *pair, PairOperator *opThread, int state);
     void    CalculateJ(QMPair *pair);
@@ -80,8 +81,8 @@ private:
     // Information on orbitals for segments
     map<string,string>          _seg_basisName;
     map<string,string>          _seg_orbFile;
-    map<string,bool>            _seg_has_e;
-    map<string,bool>            _seg_has_h;
+    vector<int>                 _seg_has_e;   // by NameTable segment id,
+    vector<int>                 _seg_has_h;   // -1 if no information
     map< string, vector<int> >  _seg_torbs_e;
     map< string, vector<int> >  _seg_torbs_h;
 
@@ -190,8 +191,13 @@ void IZindo::ParseOrbitalsXML(Property *opt) {
 
             _seg_basisName[segName] = "INDO";
             _seg_orbFile[segName] = orbFile;
-            _seg_has_e[segName] = has_e;
-            _seg_has_h[segName] = has_h;
+            unsigned int segId = NameTable::SegmentId(segName);
+            if (segId >= _seg_has_e.size()) {
+                _seg_has_e.resize(segId+1, -1);
+                _seg_has_h.resize(segId+1, -1);
+            }
+            _seg_has_e[segId] = has_e;
+            _seg_has_h[segId] = has_h;
             _seg_torbs_e[segName] = torbs_e;
             _seg_torbs_h[segName] = torbs_h;
 
@@ -206,20 +212,22 @@ void IZindo::EvalPair(Topology *top, QMPair *qmpair, PairOperator *opThread) {
     cout << "\r... ... Evaluating pair " << qmpair->getId() << flush;
     this->UnlockCout();
 
-    string segName1 = qmpair->Seg1()->getName();
-    string segName2 = qmpair->Seg2()->getName();
+    unsigned int segId1 = qmpair->Seg1()->getNameId();
+    unsigned int segId2 = qmpair->Seg2()->getNameId();
 
     bool pair_has_e = false;
     bool pair_has_h = false;
 
-    try {
-        pair_has_e = _seg_has_e.at(segName1) && _seg_has_e.at(segName2);
-        pair_has_h = _seg_has_h.at(segName1) && _seg_has_h.at(segName2);
+    if (segId1 < _seg_has_e.size() && _seg_has_e[segId1] >= 0
+     && segId2 < _seg_has_e.size() && _seg_has_e[segId2] >= 0) {
+        pair_has_e = _seg_has_e[segId1] && _seg_has_e[segId2];
+        pair_has_h = _seg_has_h[segId1] && _seg_has_h[segId2];
     }
-    catch (out_of_range&) {
+    else {
         this->LockCout();
         cout << endl << "... ... WARNING: No orbital information for pair ["
-                     << segName1 << ", " << segName2 << "]. "
+                     << qmpair->Seg1()->getName() << ", " 
+                     << qmpair->Seg2()->getName() << "]. "
                      << "Skipping... " << endl;
         this->UnlockCout();
 
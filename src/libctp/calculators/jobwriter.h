@@ -37,6 +37,7 @@ public:
     string Identify() { return "jobwriter"; }
     void Initialize(Property *options);
     bool EvaluateFrame(Topology *top);    
+    int  TopologyParts() { return TOP_SEGMENTS | TOP_PAIRS; }
     
     // NEED TO REGISTER ALL WRITE MEMBERS IN ::Initialize
     void mps_ct(Topology *top);
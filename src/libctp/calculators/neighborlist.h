@@ -25,6 +25,11 @@
 #include <votca/tools/globals.h>
 #include <votca/ctp/qmcalculator.h>
 #include <votca/ctp/qmpair.h>
+#include <votca/ctp/nametable.h>
+#include <votca/ctp/celllist.h>
+#include <votca/ctp/qmthread.h>
+#include <votca/tools/mutex.h>
+#include <algorithm>
 
 
 namespace votca { namespace ctp {
@@ -48,16 +53,24 @@ public:
     
     void Initialize(Property *options);
     bool EvaluateFrame(Topology *top);
-    void GenerateFromFile(Topology *top, string filename);
+    // Not with a Verlet skin, the list is carried from frame to frame
+    bool FrameIndependent() { return !(_skin > 0.0); }
+    void GenerateFromFile(Topology *top, string filename, Logger &log);
 
 private:
 
     bool _useConstantCutoff;
     double _constantCutoff;
-    std::map< std::string, std::map<std::string, double> > _cutoffs;
+
+    // Per pair of segment names (NameTable ids, _nSegNames x _nSegNames):
+    // cut-off and index into _fragLists, -1 if the pair has no cut-off
+    int _nSegNames;
+    std::vector<double> _cutoffs;
+    std::vector<int> _fragListIds;
+    std::vector<std::string> _fragLists;
+    double _maxCutoff;                  // cell size of the neighbour search
 
     bool _use_active_fragments;
-    std::map< std::string, std::map<std::string, std::string> > _active_fragments;
     
     bool _generate_from_file;
     std::string _file_name;
@@ -65,31 +78,93 @@ private:
     std::list<QMNBList::SuperExchangeType*> _superexchange;
 
     Logger _log;
+    void SetupLogger(Logger &log);
+
+    // Per-frame inputs of the pair search, shared by its threads
+    struct SearchFrame
+    {
+        Topology *top;
+        const TopologyArrays *arrays;
+        CellList cells;
+        std::vector<char> fragActive;   // fragment list x fragment name id
+        int nFragNames;
+        double skin;                    // added to all cut-offs
+        std::vector<double> segRadius;  // largest centre-fragment distance
+
+        // Chunks of segments (as seg1) handed out to the threads
+        int chunkSize;
+        int nChunks;
+        int nextChunk;
+        Mutex mutex;
+        std::vector< std::vector< std::pair<int,int> > > chunkPairs;
+    };
+
+    class PairSearch : public QMThread
+    {
+    public:
+        PairSearch(Neighborlist *master, SearchFrame *frame)
+            : _master(master), _frame(frame) { ; }
+       ~PairSearch() { ; }
+        void Run(void);
+    private:
+        Neighborlist *_master;
+        SearchFrame  *_frame;
+    };
+
+    // Pairs (seg1, seg2 > seg1) of segment index s1, ascending in seg2
+    void SearchSegment(SearchFrame &frame, int s1,
+        std::vector<int> &candidates, std::vector<int> &partners,
+        std::vector< std::pair<int,int> > &pairs);
+    // Whether two active fragments are within cut-off + skin
+    bool InRange(SearchFrame &frame, int s1, int s2, double skin);
+    // Lower bound of the distance between any images of r1 and r2
+    double MinImageDistance(Topology *top, const vec &r1, const vec &r2);
+
+    // Verlet skin: pairs within cut-off + skin at the last search, checked
+    // again each frame until some fragment has moved by more than skin/2
+    double _skin;
+    bool _skinValid;
+    std::vector< std::pair<int,int> > _skinPairs;
+    std::vector<double> _skinFragX, _skinFragY, _skinFragZ;
+    std::vector<int> _skinFragSeg;
+    std::vector<int> _skinSegName;
+    matrix _skinBox;
+    bool SkinExpired(Topology *top, const TopologyArrays &arrays);
 
 };
     
 
-void Neighborlist::Initialize(Property *options) {
-
-    // update options with the VOTCASHARE defaults   
-    UpdateWithDefaults( options,"ctp" );
-    std::string key = "options." + Identify();
+void Neighborlist::SetupLogger(Logger &log) {
 
     // properties of the logger
-    _log.setPreface(logINFO,    "\n... ...");
-    _log.setPreface(logERROR,   "\n... ...");
-    _log.setPreface(logWARNING, "\n... ...");
-    _log.setPreface(logDEBUG,   "\n... ...");  
+    log.setPreface(logINFO,    "\n... ...");
+    log.setPreface(logERROR,   "\n... ...");
+    log.setPreface(logWARNING, "\n... ...");
+    log.setPreface(logDEBUG,   "\n... ...");  
          
     if (TOOLS::globals::verbose) {
-        _log.setReportLevel( logDEBUG ); 
+        log.setReportLevel( logDEBUG ); 
     } else {
-        _log.setReportLevel( logINFO ); 
+        log.setReportLevel( logINFO ); 
     }
+}
+
+
+void Neighborlist::Initialize(Property *options) {
+
+    // update options with the VOTCASHARE defaults   
+    UpdateWithDefaults( options,"ctp" );
+    std::string key = "options." + Identify();
+
+    this->SetupLogger(_log);
     
     list< Property* > segs = options->Select(key+".segments");
     list< Property* > ::iterator segsIt;
 
+    // (name id 1, name id 2, cut-off, fragment list) as given in the options
+    vector<int> pairIds;
+    vector<double> pairCutoffs;
+
     for (segsIt = segs.begin(); segsIt != segs.end(); segsIt++) {
       
         double cutoff = (*segsIt)->get("cutoff").as<double>();
@@ -107,8 +182,9 @@ void Neighborlist::Initialize(Property *options) {
             throw std::runtime_error("Error in options file.");
         }
 
-        _cutoffs[names[0]][names[1]] = cutoff;
-        _cutoffs[names[1]][names[0]] = cutoff;
+        pairIds.push_back(NameTable::SegmentId(names[0]));
+        pairIds.push_back(NameTable::SegmentId(names[1]));
+        pairCutoffs.push_back(cutoff);
         
         // get active fragments for each pair of segments
         
@@ -131,9 +207,23 @@ void Neighborlist::Initialize(Property *options) {
                     << std::flush;
         }
         
-        _active_fragments[names[0]][names[1]] = fragments;
-        _active_fragments[names[1]][names[0]] = fragments;
+        _fragLists.push_back(fragments);
+
+    }
 
+    // Flat tables, segments with names not in the options have larger ids
+    _nSegNames = NameTable::SegmentCount();
+    _cutoffs.assign(_nSegNames*_nSegNames, 0.0);
+    _fragListIds.assign(_nSegNames*_nSegNames, -1);
+    _maxCutoff = 0.0;
+    for (unsigned int i = 0; i < pairCutoffs.size(); ++i) {
+        int id1 = pairIds[2*i];
+        int id2 = pairIds[2*i+1];
+        _cutoffs[id1*_nSegNames+id2] = pairCutoffs[i];
+        _cutoffs[id2*_nSegNames+id1] = pairCutoffs[i];
+        _fragListIds[id1*_nSegNames+id2] = i;
+        _fragListIds[id2*_nSegNames+id1] = i;
+        _maxCutoff = std::max(_maxCutoff, pairCutoffs[i]);
     }
 
     if (options->exists(key+".constant")) {
@@ -144,6 +234,12 @@ void Neighborlist::Initialize(Property *options) {
         _useConstantCutoff = false;
     }
 
+    _skin = 0.0;
+    _skinValid = false;
+    if (options->exists(key+".skin")) {
+        _skin = options->get(key+".skin").as< double >();
+    }
+
     _generate_from_file = false;    
     if (options->exists(key+".file")) {
         _file_name = options->get(key+".file").as< string >();
@@ -166,101 +262,156 @@ void Neighborlist::Initialize(Property *options) {
 
 bool Neighborlist::EvaluateFrame(Topology *top) {
 
+    // Own logger per frame, frames may be evaluated concurrently
+    Logger log;
+    this->SetupLogger(log);
+
     top->NBList().Cleanup();
 
     if (_generate_from_file) { 
-        this->GenerateFromFile(top, _file_name); 
+        this->GenerateFromFile(top, _file_name, log); 
     }
     else {        
 
-        vector< Segment* > ::iterator segit1;
-        vector< Segment* > ::iterator segit2;
-        vector< Fragment* > ::iterator fragit1;
-        vector< Fragment* > ::iterator fragit2;
+        // Fragment positions from the flat arrays, not the fragment objects
+        SearchFrame frame;
+        frame.top = top;
+        frame.arrays = &top->Arrays();
+        const TopologyArrays &arrays = *frame.arrays;
+        int nSegs = arrays.segments.size();
+
+        // Which fragment names each fragment list selects, matched once per
+        // frame instead of per fragment pair
+        int nFragNames = NameTable::FragmentCount();
+        frame.nFragNames = nFragNames;
+        frame.fragActive.assign(_fragLists.size()*nFragNames, 0);
+        for (unsigned int k = 0; k < _fragLists.size(); ++k) {
+            for (int f = 0; f < nFragNames; ++f) {
+                frame.fragActive[k*nFragNames+f] = (_fragLists[k].find(
+                    NameTable::FragmentName(f)) != std::string::npos);
+            }
+        }
 
-        double cutoff;
-        std::string fragment_list;
-        
-        vec r1;
-        vec r2;    
-        
-        for (segit1 = top->Segments().begin();
-                segit1 < top->Segments().end();
-                segit1++) {
-
-                Segment *seg1 = *segit1;
-                CTP_LOG(logDEBUG,_log) << "NB List Seg " << seg1->getId() << std::flush;
-
-            for (segit2 = segit1 + 1;
-                    segit2 < top->Segments().end();
-                    segit2++) {
-
-                Segment *seg2 = *segit2;
-
-                if (!_useConstantCutoff) {
-                    // Find cut-off
-                    try {
-                        cutoff = _cutoffs.at(seg1->getName())
-                                         .at(seg2->getName());
-                        
-                        fragment_list = _active_fragments.at(seg1->getName())
-                                                         .at(seg2->getName());
-                    }
-                    catch (out_of_range&) {
-                        CTP_LOG(logERROR,_log) << "ERROR: No cut-off specified for segment pair "
-                             << seg1->getName() << " | " << seg2->getName() 
-                             << ". " << std::flush;
-                        throw std::runtime_error("Missing input in options.");
-                    }
-                }
+        // Bounding spheres around the segment centres, for rejecting pairs
+        // before their fragments are compared
+        frame.segRadius.assign(nSegs, 0.0);
+        for (int s = 0; s < nSegs; ++s) {
+            vec c(arrays.segX[s], arrays.segY[s], arrays.segZ[s]);
+            for (int f = arrays.segFragBegin[s]; f < arrays.segFragBegin[s+1];
+                ++f) {
+                vec r(arrays.fragX[f], arrays.fragY[f], arrays.fragZ[f]);
+                frame.segRadius[s] = std::max(frame.segRadius[s],
+                    abs(top->PbShortestConnect(c, r)));
+            }
+        }
 
-                else { cutoff = _constantCutoff; }
-
-
-                bool stopLoop = false;
-                for (fragit1 = seg1->Fragments().begin();
-                        fragit1 < seg1->Fragments().end();
-                        fragit1 ++) {
-
-                    // check if this fragment is active
-                    std::string _frag1name = (*fragit1)->getName();
-                    std::size_t found1 = fragment_list.find(_frag1name);
-                    if ( _use_active_fragments && found1 == std::string::npos) { continue; }
-                    
-                    if (stopLoop) { break; }
-
-                    for (fragit2 = seg2->Fragments().begin();
-                            fragit2 < seg2->Fragments().end();
-                            fragit2++) {
-
-                        // check if this fragment is active
-                        std::string _frag2name = (*fragit1)->getName();
-                        std::size_t found2 = fragment_list.find(_frag2name);
-                        if (_use_active_fragments && found2 == std::string::npos) { continue; }
-
-                        r1 = (*fragit1)->getPos();
-                        r2 = (*fragit2)->getPos();
-                        if( abs( top->PbShortestConnect(r1, r2) ) > cutoff ) {
-                            continue;
-                        }
-                        else {
-                            top->NBList().Add(seg1, seg2);
-                            stopLoop = true;
-                            break;
-                        }                
-
-                    } /* exit loop frag2 */
-                } /* exit loop frag1 */
-            } /* exit loop seg2 */
-                
-               // break;
-        } /* exit loop seg1 */       
+        // Every pair of segment names in this frame needs a cut-off, also
+        // those of segments too far apart to ever be tested below
+        if (!_useConstantCutoff) {
+            std::vector<int> nPerName(NameTable::SegmentCount(), 0);
+            for (int s = 0; s < nSegs; ++s) nPerName[arrays.segName[s]] += 1;
+            for (unsigned int id1 = 0; id1 < nPerName.size(); ++id1) {
+            for (unsigned int id2 = id1; id2 < nPerName.size(); ++id2) {
+                if (nPerName[id1] == 0 || nPerName[id2] == 0
+                    || (id1 == id2 && nPerName[id1] < 2)) continue;
+                if (int(id2) < _nSegNames 
+                    && _fragListIds[id1*_nSegNames+id2] >= 0) continue;
+                CTP_LOG(logERROR,log) << "ERROR: No cut-off specified for segment pair "
+                     << NameTable::SegmentName(id1) << " | " 
+                     << NameTable::SegmentName(id2) << ". " << std::flush;
+                throw std::runtime_error("Missing input in options.");
+            }}
+        }
+
+        // With a skin, search again only once the kept list may be missing
+        // pairs; otherwise re-check the distances of the pairs in the list
+        frame.skin = (_skin > 0.0) ? _skin : 0.0;
+        bool search = !(_skin > 0.0) || !_skinValid 
+            || this->SkinExpired(top, arrays);
+        frame.nChunks = 0;
+
+        if (search) {
+            // Candidate partners from a cell list over all fragments with
+            // cells as large as the largest cut-off (+ skin); the exact test
+            // is the same as for all pairs, and so is the resulting list
+            double rc = (_useConstantCutoff) ? _constantCutoff : _maxCutoff;
+            frame.cells.Build(top, arrays.fragX, arrays.fragY, arrays.fragZ, 
+                rc + frame.skin);
+            CTP_LOG(logDEBUG,log) << "Cell list: " << frame.cells.Cells() 
+                << " cells" << std::flush;
+
+            // Threads take chunks of segments and buffer the pairs found per
+            // chunk; adding the chunks in order gives the same pair ids for
+            // any number of threads
+            int nThreads = (_nThreads > 0) ? _nThreads : 1;
+            frame.chunkSize = 64;
+            frame.nChunks = (nSegs + frame.chunkSize - 1) / frame.chunkSize;
+            frame.nextChunk = 0;
+            frame.chunkPairs.resize(frame.nChunks);
+
+            vector<PairSearch*> searches;
+            for (int id = 0; id < nThreads; id++) {
+                searches.push_back(new PairSearch(this, &frame));
+            }
+            for (int id = 0; id < nThreads; id++) {
+                searches[id]->Start();
+            }
+            for (int id = 0; id < nThreads; id++) {
+                searches[id]->WaitDone();
+            }
+            for (int id = 0; id < nThreads; id++) {
+                delete searches[id];
+            }
+            searches.clear();
+        }
+
+        if (_skin > 0.0) {
+            if (search) {
+                _skinPairs.clear();
+                for (int c = 0; c < frame.nChunks; ++c) {
+                    _skinPairs.insert(_skinPairs.end(), 
+                        frame.chunkPairs[c].begin(), frame.chunkPairs[c].end());
+                }
+                _skinFragX = arrays.fragX;
+                _skinFragY = arrays.fragY;
+                _skinFragZ = arrays.fragZ;
+                _skinFragSeg = arrays.fragSeg;
+                _skinSegName = arrays.segName;
+                _skinBox = top->getBox();
+                _skinValid = true;
+            }
+            CTP_LOG(logINFO,log) << ((search) ? "Searched" : "Kept") 
+                << " list of " << _skinPairs.size() << " pairs within cut-off"
+                << " + skin." << std::flush;
+
+            // In (seg1, seg2) order like the search
+            for (unsigned int i = 0; i < _skinPairs.size(); ++i) {
+                int s1 = _skinPairs[i].first;
+                int s2 = _skinPairs[i].second;
+                if (this->InRange(frame, s1, s2, 0.0)) {
+                    top->NBList().Add(arrays.segments[s1], arrays.segments[s2]);
+                }
+            }
+        }
+        else {
+            for (int c = 0; c < frame.nChunks; ++c) {
+                std::vector< std::pair<int,int> > &pairs = frame.chunkPairs[c];
+                for (unsigned int i = 0; i < pairs.size(); ++i) {
+                    top->NBList().Add(arrays.segments[pairs[i].first],
+                                      arrays.segments[pairs[i].second]);
+                }
+            }
+        }
 
     }
 
-    // add superexchange pairs
-    top->NBList().setSuperExchangeTypes(_superexchange);
-    top->NBList().GenerateSuperExchange();
+    // add superexchange pairs, the topology owns (and deletes) its copy
+    std::list<QMNBList::SuperExchangeType*> superexchange;
+    for ( std::list<QMNBList::SuperExchangeType*>::iterator it = _superexchange.begin() ; it != _superexchange.end(); it++  ) {
+        superexchange.push_back(new QMNBList::SuperExchangeType((*it)->asString()));
+    }
+    top->NBList().setSuperExchangeTypes(superexchange);
+    top->NBList().GenerateSuperExchange((_nThreads > 0) ? _nThreads : 1);
 
     // short summary at the end
     std::map<int, int> npairs;
@@ -269,10 +420,10 @@ bool Neighborlist::EvaluateFrame(Topology *top) {
         npairs[pair->getType()] += 1;
     }
     
-    CTP_LOG(logINFO,_log) <<  "Created " << top->NBList().size() << " pairs." << std::flush;
-    CTP_LOG(logINFO,_log) <<  "Hopping only pairs: " << npairs[QMPair::Hopping] << std::flush;
-    CTP_LOG(logINFO,_log) <<  "Superexchange pairs: " << npairs[QMPair::SuperExchange] << std::flush;
-    CTP_LOG(logINFO,_log) <<  "Superexchange and hopping pairs: " << npairs[QMPair::SuperExchangeAndHopping] << std::flush;
+    CTP_LOG(logINFO,log) <<  "Created " << top->NBList().size() << " pairs." << std::flush;
+    CTP_LOG(logINFO,log) <<  "Hopping only pairs: " << npairs[QMPair::Hopping] << std::flush;
+    CTP_LOG(logINFO,log) <<  "Superexchange pairs: " << npairs[QMPair::SuperExchange] << std::flush;
+    CTP_LOG(logINFO,log) <<  "Superexchange and hopping pairs: " << npairs[QMPair::SuperExchangeAndHopping] << std::flush;
       
     // DEBUG output
     if (votca::tools::globals::verbose) {
@@ -280,13 +431,13 @@ bool Neighborlist::EvaluateFrame(Topology *top) {
 	Property bridges_summary;
         Property *_bridges = &bridges_summary.add("bridges","");
 
-        CTP_LOG(logDEBUG,_log) << "Bridged Pairs \n [idA:idB] com distance" << std::flush;
+        CTP_LOG(logDEBUG,log) << "Bridged Pairs \n [idA:idB] com distance" << std::flush;
         for (QMNBList::iterator ipair = top->NBList().begin(); ipair != top->NBList().end(); ++ipair) {
                 QMPair *pair = *ipair;
                 Segment* segment1 = pair->Seg1PbCopy();
                 Segment* segment2 = pair->Seg2PbCopy();
                 
-                CTP_LOG(logDEBUG,_log) << " [" << segment1->getId() << ":" << segment2->getId()<< "] " 
+                CTP_LOG(logDEBUG,log) << " [" << segment1->getId() << ":" << segment2->getId()<< "] " 
                              << pair->Dist()<< " bridges: " 
                              << (pair->getBridgingSegments()).size() 
                              << " type: " 
@@ -306,15 +457,15 @@ bool Neighborlist::EvaluateFrame(Topology *top) {
                 Property *_bridge_property = &_pair_property->add("bridge","");
 
                 for ( vector<Segment*>::iterator itb = bsegments.begin(); itb != bsegments.end(); itb++ ) {
-                    CTP_LOG(logDEBUG,_log) << (*itb)->getId() << " " ;
+                    CTP_LOG(logDEBUG,log) << (*itb)->getId() << " " ;
                     _bridge_property->setAttribute("id", (*itb)->getId());
                 }        
                 
-                CTP_LOG(logDEBUG,_log) << std::flush;
+                CTP_LOG(logDEBUG,log) << std::flush;
         }
     }
 
-    std::cout << _log;
+    std::cout << log;
     return true;        
 }
 
@@ -323,7 +474,169 @@ bool Neighborlist::EvaluateFrame(Topology *top) {
  * 2  1 3 DCV DCV     
  * 3  2 3 DCV DCV
  */ 
-void Neighborlist::GenerateFromFile(Topology *top, string filename) {
+void Neighborlist::PairSearch::Run(void) {
+
+    std::vector<int> candidates;
+    std::vector<int> partners;
+
+    while (true) {
+        _frame->mutex.Lock();
+        int chunk = _frame->nextChunk++;
+        _frame->mutex.Unlock();
+        if (chunk >= _frame->nChunks) break;
+
+        int nSegs = _frame->arrays->segments.size();
+        int end = std::min(nSegs, (chunk+1) * _frame->chunkSize);
+        for (int s1 = chunk * _frame->chunkSize; s1 < end; ++s1) {
+            _master->SearchSegment(*_frame, s1, candidates, partners,
+                _frame->chunkPairs[chunk]);
+        }
+    }
+}
+
+
+void Neighborlist::SearchSegment(SearchFrame &frame, int s1,
+    std::vector<int> &candidates, std::vector<int> &partners,
+    std::vector< std::pair<int,int> > &pairs) {
+
+    const TopologyArrays &arrays = *frame.arrays;
+
+    // Segments with a fragment near one of seg1, in list order
+    candidates.clear();
+    for (int f1 = arrays.segFragBegin[s1];
+            f1 < arrays.segFragBegin[s1+1];
+            f1++) {
+        frame.cells.Candidates(f1, candidates);
+    }
+    partners.clear();
+    for (unsigned int c = 0; c < candidates.size(); ++c) {
+        int s2 = arrays.fragSeg[candidates[c]];
+        if (s2 > s1) partners.push_back(s2);
+    }
+    std::sort(partners.begin(), partners.end());
+    partners.erase(std::unique(partners.begin(), partners.end()),
+        partners.end());
+
+    for (unsigned int p = 0; p < partners.size(); ++p) {
+        if (this->InRange(frame, s1, partners[p], frame.skin)) {
+            pairs.push_back(std::make_pair(s1, partners[p]));
+        }
+    }
+}
+
+
+bool Neighborlist::InRange(SearchFrame &frame, int s1, int s2, double skin) {
+
+    Topology *top = frame.top;
+    const TopologyArrays &arrays = *frame.arrays;
+    int nFragNames = frame.nFragNames;
+
+    double cutoff;
+    int fragList = -1;
+    
+    vec r1;
+    vec r2;    
+
+    if (!_useConstantCutoff) {
+        // Find cut-off, checked to exist in EvaluateFrame
+        int ij = arrays.segName[s1]*_nSegNames + arrays.segName[s2];
+        cutoff = _cutoffs[ij];
+        fragList = _fragListIds[ij];
+    }
+
+    else { cutoff = _constantCutoff; }
+
+    cutoff += skin;
+
+    // All fragments lie within the bounding spheres of the segments
+    vec c1(arrays.segX[s1], arrays.segY[s1], arrays.segZ[s1]);
+    vec c2(arrays.segX[s2], arrays.segY[s2], arrays.segZ[s2]);
+    if (this->MinImageDistance(top, c1, c2) 
+        > cutoff + frame.segRadius[s1] + frame.segRadius[s2]) {
+        return false;
+    }
+
+    for (int f1 = arrays.segFragBegin[s1];
+            f1 < arrays.segFragBegin[s1+1];
+            f1++) {
+
+        // check if this fragment is active
+        bool active1 = fragList >= 0 
+            && frame.fragActive[fragList*nFragNames+arrays.fragName[f1]];
+        if ( _use_active_fragments && !active1) { continue; }
+
+        for (int f2 = arrays.segFragBegin[s2];
+                f2 < arrays.segFragBegin[s2+1];
+                f2++) {
+
+            // check if this fragment is active
+            bool active2 = fragList >= 0 
+                && frame.fragActive[fragList*nFragNames+arrays.fragName[f2]];
+            if (_use_active_fragments && !active2) { continue; }
+
+            r1 = vec(arrays.fragX[f1], arrays.fragY[f1], arrays.fragZ[f1]);
+            r2 = vec(arrays.fragX[f2], arrays.fragY[f2], arrays.fragZ[f2]);
+            if( abs( top->PbShortestConnect(r1, r2) ) <= cutoff ) {
+                return true;
+            }
+
+        } /* exit loop frag2 */
+    } /* exit loop frag1 */
+
+    return false;
+}
+
+
+double Neighborlist::MinImageDistance(Topology *top, const vec &r1, 
+    const vec &r2) {
+
+    vec dr = top->PbShortestConnect(r1, r2);
+    double d = abs(dr);
+
+    // For triclinic boxes the boundary condition's image need not be the
+    // shortest one, compare with the neighbouring images too
+    if (top->getBoxType() == CSG::BoundaryCondition::typeTriclinic) {
+        const matrix &box = top->getBox();
+        vec a = box.getCol(0);
+        vec b = box.getCol(1);
+        vec c = box.getCol(2);
+        for (int i = -1; i <= 1; ++i) {
+        for (int j = -1; j <= 1; ++j) {
+        for (int k = -1; k <= 1; ++k) {
+            d = std::min(d, abs(dr + double(i)*a + double(j)*b + double(k)*c));
+        }}}
+    }
+    return d;
+}
+
+
+bool Neighborlist::SkinExpired(Topology *top, const TopologyArrays &arrays) {
+
+    // Different segments or box: the kept list does not apply
+    if (_skinFragSeg != arrays.fragSeg || _skinSegName != arrays.segName) {
+        return true;
+    }
+    const matrix &box = top->getBox();
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            if (box.get(i,j) != _skinBox.get(i,j)) return true;
+        }
+    }
+
+    // A pair that has come into range has closed in by at most twice the
+    // largest displacement, which is within the skin up to skin/2
+    double limit = 0.5 * _skin;
+    for (unsigned int f = 0; f < arrays.fragX.size(); ++f) {
+        vec r0(_skinFragX[f], _skinFragY[f], _skinFragZ[f]);
+        vec r(arrays.fragX[f], arrays.fragY[f], arrays.fragZ[f]);
+        if (abs(top->PbShortestConnect(r0, r)) > limit) return true;
+    }
+    return false;
+}
+
+
+void Neighborlist::GenerateFromFile(Topology *top, string filename,
+    Logger &log) {
     
     std::string line;
     std::ifstream intt;
@@ -357,7 +670,7 @@ void Neighborlist::GenerateFromFile(Topology *top, string filename) {
         } /* Exit loop over lines */
     }
     else { 
-        CTP_LOG(logERROR,_log) << "ERROR: No such file " << filename << std::flush;
+        CTP_LOG(logERROR,log) << "ERROR: No such file " << filename << std::flush;
         throw std::runtime_error("Supply input file."); 
     }    
 }
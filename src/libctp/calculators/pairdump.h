@@ -18,6 +18,7 @@ public:
 
     void    Initialize(Property *options);
     bool    EvaluateFrame(Topology *top);
+    int     TopologyParts() { return TOP_SEGMENTS | TOP_FRAGMENTS | TOP_ATOMS | TOP_PAIRS; }
 
 private:
 
@@ -21,7 +21,7 @@
 #ifndef Rates_H
 #define Rates_H
 
-#include <votca/ctp/paircalculator.h>
+#include <votca/ctp/parallelpaircalc.h>
 #include <math.h>
 #include <cmath>
 #include <complex>
@@ -36,7 +36,7 @@ namespace votca { namespace ctp {
 * *
 */
 
-class Rates : public PairCalculator2
+class Rates : public ParallelPairCalculator
 {
 public:
 
@@ -46,7 +46,13 @@ public:
     string Identify() { return "rates"; }
 
     void Initialize(Property *options);
+    int  TopologyParts() { return TOP_SEGMENTS | TOP_PAIRS; }
+    // CalculateRate only reads options (alpha' included): no state carried
+    // from pair to pair, nor from frame to frame
+    bool FrameIndependent() { return true; }
+    bool PairLocal() { return true; }
     void ParseEnergiesXML(Topology *top, Property *opt);
+    void EvalPair(Topology *top, QMPair *pair, PairOperator *opThread);
     void EvaluatePair(Topology *top, QMPair *pair);
     void CalculateRate(Topology *top, QMPair *pair, int state);
 
@@ -343,18 +349,22 @@ void Rates::ParseEnergiesXML(Topology *top, Property *opt) {
 }
 
 
+void Rates::EvalPair(Topology *top, QMPair *qmpair, PairOperator *opThread) {
+    this->EvaluatePair(top, qmpair);
+}
+
+
 void Rates::EvaluatePair(Topology *top, QMPair *qmpair) {
 
+    this->LockCout();
     cout << "\r... ... Evaluating pair " << qmpair->getId()+1 << ". " << flush;
+    this->UnlockCout();
 
     bool pair_has_e = false;
     bool pair_has_h = false;
     bool pair_has_s = false;
     bool pair_has_t = false;
 
-    string segName1 = qmpair->first->getName();
-    string segName2 = qmpair->second->getName();
-
     pair_has_e = qmpair->isPathCarrier(-1);
     pair_has_h = qmpair->isPathCarrier(+1);
     pair_has_s = qmpair->isPathCarrier(+2);
@@ -529,30 +539,31 @@ void Rates::CalculateRate(Topology *top, QMPair *qmpair, int state) {
 
     } else if (_rateType == "weissdorsey") {
         
-        _kondo = _kondo/2+1; // going from alpha to alpha'
+        // Going from alpha to alpha': local, the member is shared by all pairs
+        double kondo = _kondo/2+1;
 
         reorg12 = reorg12 + lOut;
         reorg21 = reorg21 + lOut;
         
-        double characfreq12 = reorg12 /2 /_kondo/hbar_eV;
-        double characfreq21 = reorg21 /2 /_kondo/hbar_eV;
+        double characfreq12 = reorg12 /2 /kondo/hbar_eV;
+        double characfreq21 = reorg21 /2 /kondo/hbar_eV;
         
         complex<double> M_I = complex<double>(0.0,1.0);
        /* cout << endl;
-       cout << "  CGAMMA via GSL: " << gsl_sf_gamma(2*_kondo) << " native: " << ccgamma(2*_kondo,0).real() << endl;
-       cout << " LCGAMMA via GSL: " << cgamma(_kondo+M_I*(+dG/2/M_PI/_kT)) << " native: " << ccgamma(_kondo+M_I*(+dG/2/M_PI/_kT),0) << endl;
+       cout << "  CGAMMA via GSL: " << gsl_sf_gamma(2*kondo) << " native: " << ccgamma(2*kondo,0).real() << endl;
+       cout << " LCGAMMA via GSL: " << cgamma(kondo+M_I*(+dG/2/M_PI/_kT)) << " native: " << ccgamma(kondo+M_I*(+dG/2/M_PI/_kT),0) << endl;
       */
         
        rate12 = J2/pow(hbar_eV,2)/characfreq12
-                * pow((hbar_eV*characfreq12/2/M_PI/_kT), (1-2*_kondo))
-                * pow(std::abs(ccgamma(_kondo+M_I*(+dG/2/M_PI/_kT),1)),2)
-                * pow(ccgamma(2*_kondo,0).real(), -1) * exp(+dG/2/_kT)
+                * pow((hbar_eV*characfreq12/2/M_PI/_kT), (1-2*kondo))
+                * pow(std::abs(ccgamma(kondo+M_I*(+dG/2/M_PI/_kT),1)),2)
+                * pow(ccgamma(2*kondo,0).real(), -1) * exp(+dG/2/_kT)
                 * exp(-std::abs(dG)/hbar_eV/characfreq12); 
 
         rate21 = J2/pow(hbar_eV,2)/characfreq21
-                * pow((hbar_eV*characfreq21/2/M_PI/_kT), (1-2*_kondo))
-                * pow(std::abs(ccgamma(_kondo+M_I*(-dG/2/M_PI/_kT),1)),2)
-                * pow(ccgamma(2*_kondo,0).real(), -1) * exp(-dG/2/_kT)
+                * pow((hbar_eV*characfreq21/2/M_PI/_kT), (1-2*kondo))
+                * pow(std::abs(ccgamma(kondo+M_I*(-dG/2/M_PI/_kT),1)),2)
+                * pow(ccgamma(2*kondo,0).real(), -1) * exp(-dG/2/_kT)
                 * exp(-std::abs(dG)/hbar_eV/characfreq12);
 
         
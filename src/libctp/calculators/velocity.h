@@ -16,6 +16,7 @@ public:
     string Identify() { return "Velocity"; }
     void Initialize(Property *opt);
     bool EvaluateFrame(Topology *top);
+    int  TopologyParts() { return TOP_SEGMENTS | TOP_PAIRS; }
 
 private:
 
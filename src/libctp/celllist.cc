@@ -0,0 +1,139 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+#include <votca/ctp/celllist.h>
+#include <algorithm>
+#include <cmath>
+
+namespace votca { namespace ctp {
+
+
+void CellList::Build(Topology *top, const vector<double> &x,
+    const vector<double> &y, const vector<double> &z, double rc) {
+
+    int N = x.size();
+    double width[3];
+
+    _periodic = false;
+    if (top->getBoxType() != CSG::BoundaryCondition::typeOpen) {
+        const matrix &box = top->getBox();
+        vec a = box.getCol(0);
+        vec b = box.getCol(1);
+        vec c = box.getCol(2);
+        double volume = a * (b ^ c);
+        if (std::abs(volume) > 0.0) {
+            _periodic = true;
+            _recip[0] = (b ^ c) / volume;
+            _recip[1] = (c ^ a) / volume;
+            _recip[2] = (a ^ b) / volume;
+            // Distance between opposite faces of the box
+            for (int k = 0; k < 3; ++k) width[k] = 1.0 / abs(_recip[k]);
+        }
+    }
+    if (!_periodic) {
+        for (int k = 0; k < 3; ++k) { _lo[k] = 0.0; _hi[k] = 0.0; }
+        for (int i = 0; i < N; ++i) {
+            double r[3] = { x[i], y[i], z[i] };
+            for (int k = 0; k < 3; ++k) {
+                if (i == 0 || r[k] < _lo[k]) _lo[k] = r[k];
+                if (i == 0 || r[k] > _hi[k]) _hi[k] = r[k];
+            }
+        }
+        for (int k = 0; k < 3; ++k) width[k] = _hi[k] - _lo[k];
+    }
+
+    // Cells at least rc wide; no more cells than needed to hold the points
+    for (int k = 0; k < 3; ++k) {
+        double n = (rc > 0.0) ? std::floor(width[k] / rc) : 1.0;
+        _n[k] = (n >= 1.0 && n < 1024.0) ? int(n) : ((n >= 1024.0) ? 1024 : 1);
+    }
+    while (double(_n[0])*_n[1]*_n[2] > 2.0*N + 1.0) {
+        int k = std::max_element(_n, _n+3) - _n;
+        _n[k] = std::max(1, _n[k] / 2);
+    }
+
+    // Counting sort of the points by cell
+    _cellOf.resize(N);
+    _cellBegin.assign(this->Cells()+1, 0);
+    for (int i = 0; i < N; ++i) {
+        int idx[3];
+        for (int k = 0; k < 3; ++k) {
+            double s;
+            if (_periodic) {
+                s = _recip[k] * vec(x[i], y[i], z[i]);
+                s -= std::floor(s);
+            }
+            else {
+                double r = (k == 0) ? x[i] : ((k == 1) ? y[i] : z[i]);
+                s = (width[k] > 0.0) ? (r - _lo[k]) / width[k] : 0.0;
+            }
+            idx[k] = std::min(_n[k]-1, std::max(0, int(s * _n[k])));
+        }
+        _cellOf[i] = (idx[0]*_n[1] + idx[1])*_n[2] + idx[2];
+        _cellBegin[_cellOf[i]+1] += 1;
+    }
+    for (int c = 0; c < this->Cells(); ++c) {
+        _cellBegin[c+1] += _cellBegin[c];
+    }
+    _points.resize(N);
+    vector<int> fill(_cellBegin.begin(), _cellBegin.end()-1);
+    for (int i = 0; i < N; ++i) {
+        _points[fill[_cellOf[i]]++] = i;
+    }
+}
+
+
+int CellList::Adjacent(int k, int c, int *adj) const {
+    int count = 0;
+    for (int d = -1; d <= 1; ++d) {
+        int cc = c + d;
+        if (_periodic) {
+            cc = (cc + _n[k]) % _n[k];
+        }
+        else if (cc < 0 || cc >= _n[k]) {
+            continue;
+        }
+        // Fewer than three cells: offsets wrap onto the same cell
+        if (std::find(adj, adj+count, cc) == adj+count) adj[count++] = cc;
+    }
+    return count;
+}
+
+
+void CellList::Candidates(int i, vector<int> &nbs) const {
+
+    int cell = _cellOf[i];
+    int c[3] = { cell / (_n[1]*_n[2]), (cell / _n[2]) % _n[1], cell % _n[2] };
+
+    int adj[3][3];
+    int nadj[3];
+    for (int k = 0; k < 3; ++k) nadj[k] = this->Adjacent(k, c[k], adj[k]);
+
+    for (int a = 0; a < nadj[0]; ++a) {
+    for (int b = 0; b < nadj[1]; ++b) {
+    for (int d = 0; d < nadj[2]; ++d) {
+        int cc = (adj[0][a]*_n[1] + adj[1][b])*_n[2] + adj[2][d];
+        nbs.insert(nbs.end(), _points.begin() + _cellBegin[cc],
+                              _points.begin() + _cellBegin[cc+1]);
+    }}}
+}
+
+
+}}
@@ -192,6 +192,7 @@ Ewald3DnD::Ewald3DnD(Topology *top, PolarTop *ptop, Property *opt, Logger *log)
     
     _did_field_pin_R_shell = false;
     _did_generate_kvectors = false;
+    _field_cache = NULL;
     
     // SET-UP REAL & RECIPROCAL SPACE
     _a = _top->getBox().getCol(0);
@@ -1251,7 +1252,21 @@ void Ewald3DnD::Evaluate() {
     boost::timer::cpu_timer cpu_t;
     cpu_t.start();
     boost::timer::cpu_times t0 = cpu_t.elapsed();
-    if (_task_calculate_fields) EvaluateFields(true);
+    if (_task_calculate_fields) {
+        // Shared fields leave no pinned neighbours or k-vectors behind:
+        // the energy sums regenerate these themselves
+        if (_field_cache && _field_cache->Fetch(_field_cache_key, _fg_C,
+            _field_converged_R, _field_converged_K)) {
+            CTP_LOG(logDEBUG,*_log) << flush 
+                << "Foreground fields shared from '" << _field_cache_key 
+                << "'" << flush;
+        }
+        else {
+            EvaluateFields(true);
+            if (_field_cache) _field_cache->Store(_field_cache_key, _fg_C,
+                _field_converged_R, _field_converged_K);
+        }
+    }
     boost::timer::cpu_times t1 = cpu_t.elapsed();
     if (_task_polarize_fg) EvaluateInduction();
     else _polar_converged = true;
@@ -1382,6 +1397,89 @@ void Ewald3DnD::Evaluate() {
 }
 
 
+bool EwdFieldCache::Fetch(const string &key, vector<PolarSeg*> &fg, 
+    bool &converged_R, bool &converged_K) {
+    
+    _lock.Lock();
+    map<string, Fields>::iterator fit = _fields.find(key);
+    if (fit == _fields.end()) {
+        _lock.Unlock();
+        return false;
+    }
+    Fields &fields = fit->second;
+    
+    // Same sites at the same positions?
+    unsigned int n = 0;
+    bool match = true;
+    vector<PolarSeg*>::iterator sit;
+    vector<APolarSite*>::iterator pit;
+    for (sit = fg.begin(); sit < fg.end() && match; ++sit) {
+        for (pit = (*sit)->begin(); pit < (*sit)->end(); ++pit, ++n) {
+            if (n >= fields.pos.size() 
+                || votca::tools::abs((*pit)->getPos()-fields.pos[n]) > 1e-8) {
+                match = false;
+                break;
+            }
+        }
+    }
+    if (!match || n != fields.pos.size()) {
+        _lock.Unlock();
+        return false;
+    }
+    
+    n = 0;
+    for (sit = fg.begin(); sit < fg.end(); ++sit) {
+        for (pit = (*sit)->begin(); pit < (*sit)->end(); ++pit, ++n) {
+            (*pit)->Depolarize();
+            double fpx = fields.fp[n].getX();
+            double fpy = fields.fp[n].getY();
+            double fpz = fields.fp[n].getZ();
+            double fux = fields.fu[n].getX();
+            double fuy = fields.fu[n].getY();
+            double fuz = fields.fu[n].getZ();
+            (*pit)->setFieldP(fpx, fpy, fpz);
+            (*pit)->setFieldU(fux, fuy, fuz);
+        }
+    }
+    converged_R = fields.converged_R;
+    converged_K = fields.converged_K;
+    _lru.remove(key);
+    _lru.push_front(key);
+    _lock.Unlock();
+    return true;
+}
+
+
+void EwdFieldCache::Store(const string &key, vector<PolarSeg*> &fg, 
+    bool converged_R, bool converged_K) {
+    
+    if (_capacity < 1) return;
+    Fields fields;
+    vector<PolarSeg*>::iterator sit;
+    vector<APolarSite*>::iterator pit;
+    for (sit = fg.begin(); sit < fg.end(); ++sit) {
+        for (pit = (*sit)->begin(); pit < (*sit)->end(); ++pit) {
+            fields.pos.push_back((*pit)->getPos());
+            fields.fp.push_back((*pit)->getFieldP());
+            fields.fu.push_back((*pit)->getFieldU());
+        }
+    }
+    fields.converged_R = converged_R;
+    fields.converged_K = converged_K;
+    
+    _lock.Lock();
+    if (_fields.find(key) != _fields.end()) _lru.remove(key);
+    _fields[key] = fields;
+    _lru.push_front(key);
+    while (int(_lru.size()) > _capacity) {
+        _fields.erase(_lru.back());
+        _lru.pop_back();
+    }
+    _lock.Unlock();
+    return;
+}
+
+
 void Ewald3DnD::EvaluateFields(bool do_depolarize_fgc) {
 
 	vector<PolarSeg*>::iterator sit;
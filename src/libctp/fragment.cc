@@ -25,6 +25,7 @@ namespace votca { namespace ctp {
 
 Fragment::Fragment(Fragment *stencil)
          : _id(stencil->getId()), _name(stencil->getName()+"_ghost"),
+           _nameId(NameTable::FragmentId(_name)),
            _top(NULL), _mol(NULL), _rotateQM2MD(stencil->getRotQM2MD()),
            _CoQM(stencil->getCoQM()), _CoMD(stencil->getCoMD()),
            _trihedron(stencil->getTrihedron()) {
@@ -1,6 +1,7 @@
 #include <votca/tools/propertyiomanipulator.h>
 #include <votca/tools/globals.h>
 #include <votca/ctp/job.h>
+#include <votca/ctp/jobreader.h>
 #include <boost/format.hpp>
 #include <boost/algorithm/string.hpp> 
 
@@ -13,7 +14,9 @@ namespace votca { namespace ctp {
     
 Job::Job(Property *prop)
   : _has_host(false), _has_time(false), _has_error(false),
-    _has_output(false), _has_sqlcmd(false) {
+    _has_output(false), _has_sqlcmd(false), _has_cost(false),
+    _has_walltime(false), _has_cputime(false), _has_rss(false), _phases(""),
+    _has_input_xml(false), _has_output_xml(false) {
    
      // DEFINED BY USER
     _id = prop->get("id").as<int>();
@@ -30,6 +33,10 @@ Job::Job(Property *prop)
         _sqlcmd = prop->get("sqlcmd").as<string>();
         _has_sqlcmd = true;
     }
+    if (prop->exists("cost")) {
+        _cost = prop->get("cost").as<double>();
+        _has_cost = true;
+    }
 
     // GENERATED DURING RUNTIME
     if (prop->exists("host")) {
@@ -48,12 +55,29 @@ Job::Job(Property *prop)
         _error = prop->get("error").as<string>();
         _has_error = true;
     }
+    if (prop->exists("walltime")) {
+        _walltime = prop->get("walltime").as<double>();
+        _has_walltime = true;
+    }
+    if (prop->exists("cputime")) {
+        _cputime = prop->get("cputime").as<double>();
+        _has_cputime = true;
+    }
+    if (prop->exists("rss")) {
+        _rss = prop->get("rss").as<long>();
+        _has_rss = true;
+    }
+    if (prop->exists("phases")) {
+        _phases = prop->get("phases").as<string>();
+    }
 }
 
 
 Job::Job(int id, string &tag, string &inputstr, string status)
   : _has_host(false), _has_time(false), _has_error(false),
-    _has_output(false), _has_sqlcmd(false) {
+    _has_output(false), _has_sqlcmd(false), _has_cost(false),
+    _has_walltime(false), _has_cputime(false), _has_rss(false), _phases(""),
+    _has_input_xml(false), _has_output_xml(false) {
     
     _id = id;
     _tag = tag;
@@ -66,7 +90,9 @@ Job::Job(int id, string &tag, string &inputstr, string status)
 
 Job::Job(int id, string &tag, Property &input, JobStatus status)
   : _has_host(false), _has_time(false), _has_error(false),
-    _has_output(false), _has_sqlcmd(false) {
+    _has_output(false), _has_sqlcmd(false), _has_cost(false),
+    _has_walltime(false), _has_cputime(false), _has_rss(false), _phases(""),
+    _has_input_xml(false), _has_output_xml(false) {
     
     _id = id;
     _tag = tag;
@@ -104,13 +130,59 @@ Job::JobStatus Job::ConvertStatus(string status) const {
 void Job::Reset() {    
     _output = Property();
     _has_output = false;
+    _has_output_xml = false;
     _error = "";
     _has_error = false;
+    _has_walltime = false;
+    _has_cputime = false;
+    _has_rss = false;
+    _phases = "";
     return;    
 }
 
+
+Property &Job::getInput() {
+    // Parses in place, i.e. no concurrent ::ToStream: the progress observer
+    // calls this under its lock before handing the job out
+    if (_has_input_xml) {
+        JobReader::PropertyFromXml(_input, _inputXml, "input");
+        _inputXml = "";
+        _has_input_xml = false;
+    }
+    return _input;
+}
+
+
+const Property &Job::getOutput() const {
+    // As ::getInput: only under the progress observer's lock
+    assert(_has_output);
+    if (_has_output_xml) {
+        JobReader::PropertyFromXml(_output, _outputXml, "output");
+        _outputXml = "";
+        _has_output_xml = false;
+    }
+    return _output;
+}
+
+
+void Job::JobResult::addPhase(string phase, double sec) {
+    // Calculator-specific timings, e.g. "induction=12.345 energy=1.234"
+    _phases += (format("%1$s%2$s=%3$1.3f") 
+        % ((_phases == "") ? "" : " ") % phase % sec).str();
+}
+
+
+int Job::getInputSize() {
+    // Size of the XML input: crude proxy for the cost of a job
+    if (_has_input_xml) return _inputXml.size();
+    votca::tools::PropertyIOManipulator iomXML(votca::tools::PropertyIOManipulator::XML, 0, "");
+    std::stringstream input;
+    input << iomXML << _input;
+    return input.str().size();
+}
+
     
-void Job::ToStream(std::ofstream &ofs, string fileformat) {
+void Job::ToStream(std::ostream &ofs, string fileformat) {
 
     votca::tools::PropertyIOManipulator iomXML(votca::tools::PropertyIOManipulator::XML, 0, "\t\t");
     //votca::tools::PropertyIOManipulator iomTXT(votca::tools::PropertyIOManipulator::TXT, 0, "\t\t");
@@ -122,25 +194,45 @@ void Job::ToStream(std::ofstream &ofs, string fileformat) {
         ofs << tab << tab << (format("<id>%1$d</id>\n") % _id).str();
         ofs << tab << tab << (format("<tag>%1$s</tag>\n") % _tag).str();
         //PropertyFormat::PrintNodeXML(ofs, _input, 0, 0, "", "\t\t");
-        ofs << iomXML << _input;
+        if (_has_input_xml) ofs << tab << tab << _inputXml << "\n";
+        else ofs << iomXML << _input;
         //ofs << tab << tab << (format("<input>%1$s</input>\n") % _input).str();
         ofs << tab << tab << (format("<status>%1$s</status>\n") % ConvertStatus(_status)).str();
 
         if (_has_sqlcmd)
             ofs << tab << tab << (format("<sqlcmd>%1$s</sqlcmd>\n") 
                 % _sqlcmd).str();    
-        if (_has_host && votca::tools::globals::verbose)
+        if (_has_cost)
+            ofs << tab << tab << (format("<cost>%1$g</cost>\n") 
+                % _cost).str();    
+        // Host & time of assigned and finished jobs: other processes merge
+        // on these (see UPDATE_JOBS), ctp_parallel --report times them
+        bool claimed = (_status != AVAILABLE);
+        if (_has_host && (claimed || votca::tools::globals::verbose))
             ofs << tab << tab << (format("<host>%1$s</host>\n") 
                 % _host).str();    
-        if (_has_time && votca::tools::globals::verbose )
+        if (_has_time && (claimed || votca::tools::globals::verbose))
             ofs << tab << tab << (format("<time>%1$s</time>\n") 
                 % _time).str();
-        if (_has_output)
+        if (_has_output && _has_output_xml)
+            ofs << tab << tab << _outputXml << "\n";
+        else if (_has_output)
             //PropertyFormat::PrintNodeXML(ofs, _output, 0, 0, "",  "\t\t");
             ofs << iomXML << _output;
         if (_has_error)
             ofs << tab << tab << (format("<error>%1$s</error>\n")
                 % _error).str();
+        if (_has_walltime)
+            ofs << tab << tab << (format("<walltime>%1$1.3f</walltime>\n")
+                % _walltime).str();
+        if (_has_cputime)
+            ofs << tab << tab << (format("<cputime>%1$1.3f</cputime>\n")
+                % _cputime).str();
+        if (_has_rss)
+            ofs << tab << tab << (format("<rss>%1$d</rss>\n") % _rss).str();
+        if (_phases != "")
+            ofs << tab << tab << (format("<phases>%1$s</phases>\n") 
+                % _phases).str();
         ofs << tab << "</job>\n";     
     }
     else if (fileformat == "tab") {
@@ -153,13 +245,48 @@ void Job::ToStream(std::ofstream &ofs, string fileformat) {
         std::stringstream input;
         std::stringstream output;
         
-        input << iomXML << _input;
-        output << iomXML << _output;
+        if (_has_input_xml) input << _inputXml;
+        else input << iomXML << _input;
+        if (_has_output_xml) output << _outputXml;
+        else output << iomXML << _output;
         
         ofs << (format("%4$10s %5$20s %6$10s %1$5d %2$10s %3$30s %7$s %8$s\n")
             % _id % _tag % input.str() % status % host
             % time % _error % output.str() ).str();
     }
+    else if (fileformat == "record") {
+        // Journal record: status change only, input is known to all readers
+        string tab = "\t";
+        
+        ofs << tab << "<job>\n";
+        ofs << tab << tab << (format("<id>%1$d</id>\n") % _id).str();
+        ofs << tab << tab << (format("<status>%1$s</status>\n") % ConvertStatus(_status)).str();
+        if (_has_host)
+            ofs << tab << tab << (format("<host>%1$s</host>\n") 
+                % _host).str();    
+        if (_has_time)
+            ofs << tab << tab << (format("<time>%1$s</time>\n") 
+                % _time).str();
+        if (_has_output && _has_output_xml)
+            ofs << tab << tab << _outputXml << "\n";
+        else if (_has_output)
+            ofs << iomXML << _output;
+        if (_has_error)
+            ofs << tab << tab << (format("<error>%1$s</error>\n")
+                % _error).str();
+        if (_has_walltime)
+            ofs << tab << tab << (format("<walltime>%1$1.3f</walltime>\n")
+                % _walltime).str();
+        if (_has_cputime)
+            ofs << tab << tab << (format("<cputime>%1$1.3f</cputime>\n")
+                % _cputime).str();
+        if (_has_rss)
+            ofs << tab << tab << (format("<rss>%1$d</rss>\n") % _rss).str();
+        if (_phases != "")
+            ofs << tab << tab << (format("<phases>%1$s</phases>\n") 
+                % _phases).str();
+        ofs << tab << "</job>\n";
+    }
     else {
         assert(false);
     }
@@ -174,25 +301,61 @@ void Job::UpdateFrom(Job *ext) {
         _status = ext->getStatus();
         if (ext->hasHost()) { _has_host = true; _host = ext->getHost(); }
         if (ext->hasTime()) { _has_time = true; _time = ext->getTime(); }
-        if (ext->hasOutput()) { _has_output = true; _output = ext->getOutput(); }
+        if (ext->hasOutput()) { 
+            // Unparsed output is passed on unparsed
+            _has_output = true; 
+            _has_output_xml = ext->_has_output_xml;
+            if (_has_output_xml) _outputXml = ext->_outputXml;
+            else _output = ext->_output;
+        }
         if (ext->hasError()) { _has_error = true; _error = ext->getError(); }
+        if (ext->hasWalltime()) { 
+            _has_walltime = true; _walltime = ext->getWalltime(); }
+        if (ext->hasCputime()) { 
+            _has_cputime = true; _cputime = ext->getCputime(); }
+        if (ext->hasRss()) { _has_rss = true; _rss = ext->getRss(); }
+        if (ext->hasPhases()) { _phases = ext->getPhases(); }
     //}
     
     return;
 }
 
 
+void Job::UpdateFromRecord(Job *rec) {
+    
+    // A fresh assignment invalidates results of earlier attempts
+    if (rec->getStatus() == ASSIGNED) this->Reset();
+    this->UpdateFrom(rec);
+    
+    return;
+}
+
+
 void Job::SaveResults(JobResult *res) {
     
     _status = res->_status;
     if (res->_has_output) {
         _output = res->_output;
         _has_output = true;
+        _has_output_xml = false;
     }
     if (res->_has_error) {
         _error = res->_error;
         _has_error = true;
     }
+    if (res->_has_walltime) {
+        _walltime = res->_walltime;
+        _has_walltime = true;
+    }
+    if (res->_has_cputime) {
+        _cputime = res->_cputime;
+        _has_cputime = true;
+    }
+    if (res->_has_rss) {
+        _rss = res->_rss;
+        _has_rss = true;
+    }
+    _phases = res->_phases;
     
     _attemptsCount += 1;
     
@@ -47,6 +47,9 @@ void JobApplication::Initialize(void) {
         "  number of threads to create");
     AddProgramOptions() ("save,s", propt::value<int>()->default_value(1),
         "  whether or not to save changes to state file");
+    AddProgramOptions() ("wal", propt::value<int>()->default_value(-1),
+        "  1: WAL journal, concurrent readers (local file systems only), "
+        "0: rollback journal, -1: keep");
     AddProgramOptions() ("restart,r", propt::value<string>()->default_value(""),
         "  restart pattern: 'host(pc1:234) stat(FAILED)'");
     AddProgramOptions() ("cache,c", propt::value<int>()->default_value(8),
@@ -55,6 +58,16 @@ void JobApplication::Initialize(void) {
         "  task(s) to perform: input, run, import");
     AddProgramOptions() ("maxjobs,m", propt::value<int>()->default_value(-1),
         "  maximum number of jobs to process (-1 = inf)");
+    AddProgramOptions() ("sync-interval", propt::value<double>()->default_value(0.),
+        "  adapt cache size to sync about every so many seconds (0 = fixed)");
+    AddProgramOptions() ("async-io", 
+        "  sync with the job file on a separate I/O thread");
+    AddProgramOptions() ("order", propt::value<string>()->default_value("file"),
+        "  order in which jobs are assigned: file, cost (longest first)");
+    AddProgramOptions() ("serve", 
+        "  hand out jobs to local workers via a socket next to the job file");
+    AddProgramOptions() ("report", 
+        "  summarize recorded job statistics of the job file, run no jobs");
 }
 
 
@@ -86,10 +99,10 @@ void JobApplication::Run() {
     // STATESAVER & PROGRESS OBSERVER
     string statefile = OptionsMap()["file"].as<string>();
     StateSaverSQLite statsav;
+    statsav.setWAL(OptionsMap()["wal"].as<int>());
     statsav.Open(_top, statefile);    
 
-    ProgObserver< vector<Job*>, Job*, Job::JobResult > progObs
-        = ProgObserver< vector<Job*>, Job*, Job::JobResult >();
+    ProgObserver< vector<Job*>, Job*, Job::JobResult > progObs;
     progObs.InitCmdLineOpts(OptionsMap());
     
     // INITIALIZE & RUN CALCULATORS
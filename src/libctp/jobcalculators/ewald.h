@@ -50,6 +50,8 @@ private:
     XMpsMap                        _mps_mapper;
     bool                           _pdb_check;
     bool                           _ptop_check;
+    bool                           _share_env;
+    EwdFieldCache                  _field_cache;
 };
 
 
@@ -72,6 +74,10 @@ void Ewald<EwaldMethod>::Initialize(Property *opt) {
             cout << endl;
             throw std::runtime_error("Job-file not set. Abort.");
         }    
+        if (opt->exists(key+".share_env")) {
+            _share_env = opt->get(key+".share_env").as<bool>();
+        }
+        else { _share_env = false; }
     
     key = "options.ewald.multipoles";
         if (opt->exists(key+".mapping")) {
@@ -110,6 +116,11 @@ void Ewald<EwaldMethod>::PreProcess(Topology *top) {
     // INITIALIZE MPS-MAPPER (=> POLAR TOP PREP)
     cout << endl << "... ... Initialize MPS-mapper: " << flush;
     _mps_mapper.GenerateMap(_xml_file, _mps_table, top);
+    // One environment per foreground in flight (e.g. n/e/h of a segment)
+    if (_share_env) {
+        _mps_mapper.setShareEnv(_nThreads);
+        _field_cache.setCapacity(_nThreads);
+    }
     return;
 }
 
@@ -322,6 +333,14 @@ Job::JobResult Ewald<EwaldMethod>::EvalJob(Topology *top, Job *job,
     // CALL THOLEWALD MAGIC
     EwaldMethod ewaldnd = EwaldMethod(top, xjob.getPolarTop(), _options, 
         thread->getLogger());
+    if (_share_env) {
+        string key = _polar_bg_arch;
+        for (unsigned int i = 0; i < xjob.getSegments().size(); ++i) {
+            key += " " + boost::lexical_cast<string>(
+                xjob.getSegments()[i]->getId());
+        }
+        ewaldnd.setFieldCache(&_field_cache, key);
+    }
     if (_pdb_check)
         ewaldnd.WriteDensitiesPDB(xjob.getTag()+".densities.pdb");
     ewaldnd.Evaluate();
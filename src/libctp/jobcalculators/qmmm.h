@@ -369,6 +369,7 @@ Job::JobResult QMMM::EvalJob(Topology *top, Job *job, QMThread *thread) {
     XInductor xind = XInductor(top, &_options, "options.qmmm",
         _subthreads, _maverick);    
     xind.setLog(thread->getLogger());
+    xind.setSubthreadPool(&_subthreadPool);
     
     //Gaussian qmpack = Gaussian(&_qmpack_opt);
 
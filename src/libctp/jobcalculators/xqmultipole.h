@@ -9,6 +9,7 @@
 #include <votca/ctp/xinteractor.h>
 #include <votca/ctp/logger.h>
 #include <boost/format.hpp>
+#include <boost/timer/timer.hpp>
 
 
 using boost::format;
@@ -51,6 +52,7 @@ private:
     
     // Control over induction-state output
     bool                            _pdb_check;
+    bool                            _share_env;
     bool                            _write_chk;
     string                          _write_chk_suffix;
     bool                            _chk_split_dpl;
@@ -119,6 +121,11 @@ void XQMP::Initialize(Property *opt) {
         }
         else { _pdb_check = false; }
 
+        if (opt->exists(key+".share_env")) {
+            _share_env = opt->get(key+".share_env").as<bool>();
+        }
+        else { _share_env = false; }
+
         if (opt->exists(key+".write_chk")) {
             _write_chk_suffix = opt->get(key+".write_chk").as<string>();
             _write_chk = true;
@@ -179,6 +186,8 @@ void XQMP::PreProcess(Topology *top) {
     // INITIALIZE MPS-MAPPER (=> POLAR TOP PREP)
     cout << endl << "... ... Initialize MPS-mapper: " << flush;
     _mps_mapper.GenerateMap(_xml_file, _emp_file, top);
+    // One environment per QM region in flight (e.g. n/e/h of a segment)
+    if (_share_env) _mps_mapper.setShareEnv(_nThreads);
 }
 
 
@@ -253,7 +262,10 @@ Job::JobResult XQMP::EvalJob(Topology *top, Job *job, QMThread *thread) {
     double co1 = _cutoff1;
     double co2 = _cutoff2;    
     
+    boost::timer::cpu_timer cpu_t;
+    cpu_t.start();
     _mps_mapper.Gen_QM_MM1_MM2(top, &xjob, co1, co2, thread);
+    double t_polartop = cpu_t.elapsed().wall/1e9;
     
     CTP_LOG(logINFO,*log)
          << xjob.getPolarTop()->ShellInfoStr() << flush;
@@ -265,6 +277,7 @@ Job::JobResult XQMP::EvalJob(Topology *top, Job *job, QMThread *thread) {
     XInductor inductor = XInductor(top, _options, "options.xqmultipole",
                                    _subthreads, _maverick);
     inductor.setLog(thread->getLogger());
+    inductor.setSubthreadPool(&_subthreadPool);
     inductor.Evaluate(&xjob);
     
 
@@ -290,6 +303,9 @@ Job::JobResult XQMP::EvalJob(Topology *top, Job *job, QMThread *thread) {
     Job::JobResult jres = Job::JobResult();
     jres.setOutput(output);
     jres.setStatus(Job::COMPLETE);
+    jres.addPhase("polartop", t_polartop);
+    jres.addPhase("induction", inductor.getTimeInduction());
+    jres.addPhase("energy", inductor.getTimeEnergy());
     
     if (!inductor.hasConverged()) {
         jres.setStatus(Job::FAILED);
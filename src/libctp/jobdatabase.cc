@@ -0,0 +1,42 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+#include <votca/ctp/jobdatabase.h>
+
+namespace votca { namespace ctp {
+
+void JobDatabase::onCreate()
+{
+    // Table format jobs
+    Exec("CREATE TABLE jobs ("
+        "id       INTEGER PRIMARY KEY,"
+        "tag      TEXT NOT NULL,"
+        "input    TEXT NOT NULL,"
+        "status   TEXT DEFAULT 'AVAILABLE',"
+        "host     TEXT DEFAULT '',"
+        "time     TEXT DEFAULT '',"
+        "output   TEXT DEFAULT '',"
+        "error    TEXT DEFAULT '')");
+    
+    // Claiming selects by status in id order
+    Exec("CREATE INDEX jobsStatus ON jobs (status, id)");
+}
+
+}}
@@ -0,0 +1,231 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+#include <votca/ctp/jobreader.h>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/format.hpp>
+#include <expat.h>
+#include <cstring>
+#include <fstream>
+#include <stack>
+#include <stdexcept>
+
+using boost::format;
+
+namespace votca { namespace ctp {
+
+
+// Parser state: <jobs> at depth 1, <job> at depth 2, job fields at depth 3
+struct JobReaderState
+{
+    vector<Job*> *jobs;
+    int depth;
+    Property fields;
+    string text;
+    bool inPayload;
+    string raw;
+    string inputXml;
+    string outputXml;
+    bool hasInput;
+    bool hasOutput;
+};
+
+
+static string EscapeXml(const char *txt, int len) {
+    string escaped;
+    escaped.reserve(len);
+    for (int i = 0; i < len; ++i) {
+        switch (txt[i]) {
+            case '&': escaped += "&amp;"; break;
+            case '<': escaped += "&lt;"; break;
+            case '>': escaped += "&gt;"; break;
+            case '"': escaped += "&quot;"; break;
+            default: escaped += txt[i];
+        }
+    }
+    return escaped;
+}
+
+
+static void JobStartHandler(void *data, const char *el, const char **attr) {
+    JobReaderState *state = (JobReaderState*) data;
+    state->depth += 1;
+    string name = el;
+
+    if (state->depth == 2 && name == "job") {
+        state->fields = Property();
+        state->hasInput = false;
+        state->hasOutput = false;
+    }
+    else if (state->depth == 3) {
+        state->text = "";
+        if (name == "input" || name == "output") {
+            state->inPayload = true;
+            state->raw = "";
+        }
+    }
+
+    // Payloads are re-serialized as they come, parsed only on demand
+    if (state->inPayload) {
+        state->raw += "<" + name;
+        for (int i = 0; attr[i]; i += 2) {
+            state->raw += " " + string(attr[i]) + "=\""
+                + EscapeXml(attr[i+1], strlen(attr[i+1])) + "\"";
+        }
+        state->raw += ">";
+    }
+}
+
+
+static void JobEndHandler(void *data, const char *el) {
+    JobReaderState *state = (JobReaderState*) data;
+    string name = el;
+
+    if (state->inPayload) state->raw += "</" + name + ">";
+
+    if (state->depth == 3) {
+        if (state->inPayload && name == "input") {
+            state->inputXml = state->raw;
+            state->hasInput = true;
+            state->inPayload = false;
+        }
+        else if (state->inPayload && name == "output") {
+            state->outputXml = state->raw;
+            state->hasOutput = true;
+            state->inPayload = false;
+        }
+        else {
+            boost::algorithm::trim(state->text);
+            state->fields.add(name, state->text);
+        }
+    }
+    else if (state->depth == 2 && name == "job") {
+        // Journal records carry id, status & results only
+        if (!state->fields.exists("tag")) state->fields.add("tag", "");
+        state->fields.add("input", "");
+        Job *job = new Job(&state->fields);
+        if (state->hasInput) job->setInputXml(state->inputXml);
+        if (state->hasOutput) job->setOutputXml(state->outputXml);
+        state->jobs->push_back(job);
+    }
+
+    state->depth -= 1;
+}
+
+
+static void JobCharHandler(void *data, const char *txt, int len) {
+    JobReaderState *state = (JobReaderState*) data;
+    if (state->inPayload) state->raw += EscapeXml(txt, len);
+    else if (state->depth == 3) state->text.append(txt, len);
+}
+
+
+void JobReader::Read(const string &job_file, vector<Job*> &jobs) {
+    std::ifstream in;
+    in.open(job_file.c_str(), std::ios::in | std::ios::binary);
+    if (!in.is_open()) {
+        throw runtime_error("Bad file handle: " + job_file);
+    }
+    this->Read(in, job_file, jobs);
+    in.close();
+}
+
+
+void JobReader::Read(std::istream &in, const string &name,
+    vector<Job*> &jobs) {
+
+    JobReaderState state;
+    state.jobs = &jobs;
+    state.depth = 0;
+    state.inPayload = false;
+    state.hasInput = false;
+    state.hasOutput = false;
+
+    XML_Parser parser = XML_ParserCreate(NULL);
+    XML_SetUserData(parser, &state);
+    XML_SetElementHandler(parser, JobStartHandler, JobEndHandler);
+    XML_SetCharacterDataHandler(parser, JobCharHandler);
+
+    // Bounded memory: one chunk of the file plus the job being read
+    const int chunkSize = 1 << 16;
+    char buffer[chunkSize];
+    bool done = false;
+    while (!done) {
+        in.read(buffer, chunkSize);
+        int len = in.gcount();
+        done = (len < chunkSize);
+        if (XML_Parse(parser, buffer, len, done) == XML_STATUS_ERROR) {
+            string error = (format("Error parsing %1$s at line %2$d: %3$s")
+                % name % XML_GetCurrentLineNumber(parser)
+                % XML_ErrorString(XML_GetErrorCode(parser))).str();
+            XML_ParserFree(parser);
+            throw runtime_error(error);
+        }
+    }
+    XML_ParserFree(parser);
+}
+
+
+static void PropStartHandler(void *data, const char *el, const char **attr) {
+    std::stack<Property*> *props = (std::stack<Property*>*) data;
+    Property &prop = props->top()->add(el, "");
+    for (int i = 0; attr[i]; i += 2) {
+        prop.setAttribute(attr[i], string(attr[i+1]));
+    }
+    props->push(&prop);
+}
+
+
+static void PropEndHandler(void *data, const char *el) {
+    std::stack<Property*> *props = (std::stack<Property*>*) data;
+    boost::algorithm::trim(props->top()->value());
+    props->pop();
+}
+
+
+static void PropCharHandler(void *data, const char *txt, int len) {
+    std::stack<Property*> *props = (std::stack<Property*>*) data;
+    props->top()->value().append(txt, len);
+}
+
+
+void JobReader::PropertyFromXml(Property &prop, const string &xml,
+    const string &key) {
+
+    Property root;
+    std::stack<Property*> props;
+    props.push(&root);
+
+    XML_Parser parser = XML_ParserCreate(NULL);
+    XML_SetUserData(parser, &props);
+    XML_SetElementHandler(parser, PropStartHandler, PropEndHandler);
+    XML_SetCharacterDataHandler(parser, PropCharHandler);
+    if (XML_Parse(parser, xml.c_str(), xml.size(), 1) == XML_STATUS_ERROR) {
+        string error = (format("Error parsing job %1$s: %2$s") % key
+            % XML_ErrorString(XML_GetErrorCode(parser))).str();
+        XML_ParserFree(parser);
+        throw runtime_error(error);
+    }
+    XML_ParserFree(parser);
+    prop = root.get(key);
+}
+
+
+}}
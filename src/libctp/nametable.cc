@@ -0,0 +1,111 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+#include <votca/ctp/nametable.h>
+#include <votca/tools/mutex.h>
+#include <map>
+#include <vector>
+
+namespace votca { namespace ctp {
+
+
+// One table per kind of name, shared by all threads (frames may be loaded
+// and evaluated concurrently)
+struct NameTableData
+{
+    std::map<std::string, int> ids;
+    std::vector<std::string>   names;
+    votca::tools::Mutex        mutex;
+
+    int Id(const std::string &name) {
+        mutex.Lock();
+        std::map<std::string, int>::iterator it = ids.find(name);
+        int id;
+        if (it != ids.end()) {
+            id = it->second;
+        }
+        else {
+            id = names.size();
+            ids[name] = id;
+            names.push_back(name);
+        }
+        mutex.Unlock();
+        return id;
+    }
+
+    int Count() {
+        mutex.Lock();
+        int count = names.size();
+        mutex.Unlock();
+        return count;
+    }
+
+    std::string Name(int id) {
+        mutex.Lock();
+        std::string name = names.at(id);
+        mutex.Unlock();
+        return name;
+    }
+};
+
+
+static NameTableData &SegmentNames() {
+    static NameTableData data;
+    return data;
+}
+
+
+static NameTableData &FragmentNames() {
+    static NameTableData data;
+    return data;
+}
+
+
+int NameTable::SegmentId(const std::string &name) {
+    return SegmentNames().Id(name);
+}
+
+
+int NameTable::FragmentId(const std::string &name) {
+    return FragmentNames().Id(name);
+}
+
+
+int NameTable::SegmentCount() {
+    return SegmentNames().Count();
+}
+
+
+int NameTable::FragmentCount() {
+    return FragmentNames().Count();
+}
+
+
+std::string NameTable::SegmentName(int id) {
+    return SegmentNames().Name(id);
+}
+
+
+std::string NameTable::FragmentName(int id) {
+    return FragmentNames().Name(id);
+}
+
+
+}}
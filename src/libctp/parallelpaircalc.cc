@@ -24,6 +24,13 @@ namespace votca { namespace ctp {
 
 bool ParallelPairCalculator::EvaluateFrame(Topology *top) {
 
+    // Pairs already went through this one in an earlier pass
+    if (_fusedInto != NULL) {
+        cout << endl << "... ... Evaluated in pass of " 
+             << _fusedInto->Identify() << "." << endl;
+        return 1;
+    }
+
     // Rigidify if (a) not rigid yet (b) rigidification at all possible
     if (!top->isRigid()) {
         bool isRigid = top->Rigidify();
@@ -34,11 +41,16 @@ bool ParallelPairCalculator::EvaluateFrame(Topology *top) {
 
     vector<PairOperator*> pairOps;
     this->InitSlotData(top);
+    for (unsigned int i = 0; i < _stages.size(); i++) {
+        _stages[i]->InitSlotData(top);
+    }
 
-    _nextPair = top->NBList().begin();
+    PairCursor cursor;
+    cursor.next = top->NBList().begin();
+    cursor.end = top->NBList().end();
 
     for (unsigned int id = 0; id < _nThreads; id++) {
-        PairOperator *newOp = new PairOperator(id, top, this);
+        PairOperator *newOp = new PairOperator(id, top, this, &cursor);
         pairOps.push_back(newOp);
     }
 
@@ -57,30 +69,39 @@ bool ParallelPairCalculator::EvaluateFrame(Topology *top) {
     pairOps.clear();
 
     this->PostProcess(top);
+    for (unsigned int i = 0; i < _stages.size(); i++) {
+        _stages[i]->PostProcess(top);
+    }
     return 1;
 }
 
 
+void ParallelPairCalculator::AddStage(ParallelPairCalculator *stage) {
+    _stages.push_back(stage);
+    stage->_fusedInto = this;
+}
+
+
 // +++++++++++++++++ //
 // Thread Management //
 // +++++++++++++++++ //
 
-QMPair *ParallelPairCalculator::RequestNextPair(int opId, Topology *top) {
+QMPair *ParallelPairCalculator::RequestNextPair(int opId, PairCursor *cursor) {
 
-    _nextPairMutex.Lock();
+    cursor->mutex.Lock();
 
     QMPair *workOnThis;
 
-    if (_nextPair == top->NBList().end()) {
+    if (cursor->next == cursor->end) {
         workOnThis = NULL;
     }
     else {
-        QMPair *workOnThat = *_nextPair;
-        _nextPair++;
+        QMPair *workOnThat = *(cursor->next);
+        cursor->next++;
         workOnThis = workOnThat;
     }
 
-    _nextPairMutex.Unlock();
+    cursor->mutex.Unlock();
 
     return workOnThis;
 }
@@ -93,10 +114,15 @@ void ParallelPairCalculator::PairOperator::Run(void) {
 
     while (true) {
 
-        QMPair *qmpair = _master->RequestNextPair(_id, _top);
+        QMPair *qmpair = _master->RequestNextPair(_id, _cursor);
 
         if (qmpair == NULL) { break; }
-        else { this->_master->EvalPair(_top, qmpair, this); }
+        
+        // All fused stages while the pair is hot
+        this->_master->EvalPair(_top, qmpair, this);
+        for (unsigned int i = 0; i < _master->_stages.size(); i++) {
+            _master->_stages[i]->EvalPair(_top, qmpair, this);
+        }
     }
 }
 
@@ -1,6 +1,9 @@
 #include <votca/ctp/parallelxjobcalc.h>
 #include <boost/algorithm/string.hpp>
 #include <boost/format.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <sys/resource.h>
+#include <time.h>
 
 using boost::format;
 
@@ -18,16 +21,8 @@ bool ParallelXJobCalc<JobContainer,pJob,rJob>::EvaluateFrame(Topology *top) {
     }
     else cout << endl << "... ... System is already rigidified." << flush;
     
-    // CONVERT THREADS INTO SUBTHREADS IF BENEFICIAL
-    if (_XJobs.size() < _nThreads && false) {
-        _subthreads = (_nThreads - _XJobs.size()) / _XJobs.size() + 1;
-        _nThreads   = _XJobs.size();
-
-        cout << endl << "... ... "
-             << "Converted threads into subthreads to increase efficiency: "
-             << "NT = " << _nThreads << ", NST = " << _subthreads
-             << flush;
-    }
+    // THREADS THAT RUN OUT OF JOBS ARE CONVERTED INTO SUBTHREADS (SEE RUN)
+    _subthreadPool.Reset();
 
     // INITIALIZE PROGRESS OBSERVER
     string progFile = _jobfile;
@@ -40,6 +35,18 @@ bool ParallelXJobCalc<JobContainer,pJob,rJob>::EvaluateFrame(Topology *top) {
     master->getLogger()->setPreface(logWARNING, "\nMST WAR");
     master->getLogger()->setPreface(logDEBUG,   "\nMST DBG");    
     _progObs->InitFromProgFile(progFile, master);
+    
+    // JOB SERVER: HAND OUT JOBS TO LOCAL WORKERS, EVALUATE NONE HERE
+    if (_progObs->isServer()) {
+        _progObs->Serve(master);
+        return true;
+    }
+    
+    // REPORT: SUMMARIZE RECORDED JOB STATISTICS, EVALUATE NONE
+    if (_progObs->isReport()) {
+        _progObs->WriteReport(master);
+        return true;
+    }
 
     // PRE-PROCESS (OVERWRITTEN IN CHILD OBJECT)
     this->PreProcess(top);
@@ -62,6 +69,8 @@ bool ParallelXJobCalc<JobContainer,pJob,rJob>::EvaluateFrame(Topology *top) {
 
     if (!_maverick) cout << endl; // REQUIRED FOR PROGRESS BAR IN OBSERVER
     
+    _progObs->StartIOThread(master);
+    
     for (unsigned int id = 0; id < _nThreads; id++) {
         jobOps[id]->Start();
     }
@@ -82,6 +91,7 @@ bool ParallelXJobCalc<JobContainer,pJob,rJob>::EvaluateFrame(Topology *top) {
     jobOps.clear();
 
 	// SYNC REMAINING COMPLETE JOBS
+    _progObs->StopIOThread(master);
 	_progObs->SyncWithProgFile(master);
     
     // POST-PROCESS (OVERWRITTEN IN CHILD OBJECT)
@@ -97,9 +107,32 @@ void ParallelXJobCalc<JobContainer,pJob,rJob>::JobOperator::Run(void) {
     while (true) {
         _job = _master->_progObs->RequestNextJob(this);
 
-        if (_job == NULL) { break; }
+        if (_job == NULL) { 
+            // Queue dry => donate core to jobs still running
+            _master->_subthreadPool.Donate();
+            break; 
+        }
         else { 
+            _master->_subthreadPool.BeginJob();
+            // Wall time; CPU time of this job thread only (induction workers 
+            // and pool subthreads are not in it); process peak RSS at job end
+            struct rusage usage;
+            struct timespec cpu0, cpu1;
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu0);
+            boost::posix_time::ptime start 
+                = boost::posix_time::microsec_clock::universal_time();
+            
             rJob res = this->_master->EvalJob(_top, _job, this);
+            
+            boost::posix_time::time_duration walltime 
+                = boost::posix_time::microsec_clock::universal_time() - start;
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu1);
+            getrusage(RUSAGE_SELF, &usage);
+            res.setWalltime(walltime.total_milliseconds()/1000.);
+            res.setCputime((cpu1.tv_sec - cpu0.tv_sec) 
+                + (cpu1.tv_nsec - cpu0.tv_nsec)/1e9);
+            res.setRss(usage.ru_maxrss);
+            _master->_subthreadPool.EndJob();
             this->_master->_progObs->ReportJobDone(_job, &res, this);
         }
     }
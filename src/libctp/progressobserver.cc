@@ -1,13 +1,25 @@
 #include <votca/ctp/progressobserver.h>
 #include <votca/ctp/qmthread.h>
+#include <votca/ctp/jobdatabase.h>
+#include <votca/ctp/jobreader.h>
+#include <votca/tools/propertyiomanipulator.h>
 #include <boost/filesystem.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/format.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/algorithm/string/replace.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/lexical_cast.hpp>
 #include <fstream>
+#include <algorithm>
+#include <cmath>
 #include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
 #include <unistd.h>
+#include <cstring>
+#include <cerrno>
 
 // Shuffling around #include directives between progobs.h and progobs.cc yields these errors:
 // /people/thnfs/homes/poelking/VOTCA_SUSE_12/src/ctp/include/votca/ctp/logger.h:83:13: error: ‘string’ was not declared in this scope
@@ -18,6 +30,68 @@ using boost::format;
 namespace votca { namespace ctp {
     
     
+// Length-prefixed messages on a stream socket: "<nbytes>\n<payload>"
+static bool SEND_MESSAGE(int fd, const string &msg) {
+    string buffer = (format("%1$d\n") % msg.size()).str() + msg;
+    size_t sent = 0;
+    while (sent < buffer.size()) {
+        ssize_t n = send(fd, buffer.data()+sent, buffer.size()-sent, 
+            MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += n;
+    }
+    return true;
+}
+
+
+// False on a broken connection or a malformed message: the server drops
+// that client only, hence no exceptions here
+static bool RECV_MESSAGE(int fd, string &msg) {
+    const size_t maxDigits = 12;
+    const size_t maxSize = size_t(1) << 28;
+    size_t size = 0;
+    size_t digits = 0;
+    char c;
+    while (true) {
+        ssize_t n = recv(fd, &c, 1, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        if (c == '\n') break;
+        if (c < '0' || c > '9' || ++digits > maxDigits) return false;
+        size = 10*size + (c - '0');
+    }
+    if (digits == 0 || size > maxSize) return false;
+    msg.resize(size);
+    size_t got = 0;
+    while (got < size) {
+        ssize_t n = recv(fd, &msg[got], size-got, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        got += n;
+    }
+    return true;
+}
+
+
+// Syncs on behalf of the job threads, see ASYNC I/O in progressobserver.h
+template<typename JobContainer, typename pJob, typename rJob>
+class ProgObserver<JobContainer,pJob,rJob>::IOThread : public QMThread
+{
+public:
+    
+    IOThread(ProgObserver *obs, QMThread *master) 
+        : _obs(obs), _master(master) { ; }
+    
+    void Run(void) { _obs->RunIOThread(_master); }
+    
+private:
+    
+    ProgObserver *_obs;
+    QMThread *_master;
+};
+
+
 template<typename JobContainer, typename pJob, typename rJob>
 pJob ProgObserver<JobContainer,pJob,rJob>::RequestNextJob(QMThread *thread) {
     
@@ -26,20 +100,50 @@ pJob ProgObserver<JobContainer,pJob,rJob>::RequestNextJob(QMThread *thread) {
     
     CTP_LOG(logDEBUG,*(thread->getLogger())) 
         << "Requesting next job" << flush;
-
-    // NEED NEW CHUNK?
-    if (_nextjit == _jobsToProc.end() && _moreJobsAvailable) {
-        SyncWithProgFile(thread);
-        _nextjit = _jobsToProc.begin();
-        if (_nextjit == _jobsToProc.end()) {
-                 _moreJobsAvailable = false;
+    
+    // ASYNC I/O: POP FROM QUEUE, ASK FOR MORE BEFORE IT RUNS DRY
+    if (_asyncIO) {
+        _lockThread.Unlock();
+        boost::unique_lock<boost::mutex> lock(_ioMutex);
+        while (true) {
+            if (int(_jobsReady.size()) <= _nThreads && !_ioDry 
+                && !_ioRequested) {
+                _ioRequested = true;
+                _ioCond.notify_all();
+            }
+            if (_jobsReady.size() > 0 || _ioDry) break;
+            _ioCond.wait(lock);
+        }
+        jobToProc = NULL;
+        if (_jobsReady.size() > 0) {
+            jobToProc = _jobsReady.front();
+            _jobsReady.pop_front();
+        }
+        lock.unlock();
+        _lockThread.Lock();
+    }
+    
+    else {
+        // NEED NEW CHUNK?
+        if (_nextjit == _jobsToProc.end() && _moreJobsAvailable) {
+            SyncWithProgFile(thread);
+            _nextjit = _jobsToProc.begin();
+            if (_nextjit == _jobsToProc.end()) {
+                _moreJobsAvailable = false;
                 CTP_LOG(logDEBUG,*(thread->getLogger()))
-                        << "Sync did not yield any new jobs." << flush;
+                    << "Sync did not yield any new jobs." << flush;
+            }
+        }
+        // TAKE A BITE
+        jobToProc = NULL;
+        if (_nextjit != _jobsToProc.end()) {
+            jobToProc = *_nextjit;
+            ++_nextjit;
         }
     }
     
     // JOBS EATEN ALL UP?
-    if (_nextjit == _jobsToProc.end()) {
+    if (jobToProc == NULL) {
         if (_maxJobs == _startJobsCount) {
             CTP_LOG(logDEBUG,*(thread->getLogger()))
                 << "Next job: ID = - (reached maximum for this process)" 
@@ -49,20 +153,20 @@ pJob ProgObserver<JobContainer,pJob,rJob>::RequestNextJob(QMThread *thread) {
             CTP_LOG(logDEBUG,*(thread->getLogger())) 
                 << "Next job: ID = - (none available)" << flush;
         }
-        jobToProc = NULL;
     }
-    // TAKE A BITE
-    else {        
-        jobToProc = *_nextjit;
-        ++_nextjit;
+    else {
         CTP_LOG(logDEBUG,*(thread->getLogger()))
             << "Next job: ID = " << jobToProc->getId() << flush;
     }
     
+    // Parse the input now, under _lockThread: the job thread reads it
+    // unlocked while syncs write the job file from the same Job
+    if (jobToProc != NULL) jobToProc->getInput();
+    
     if (!thread->isMaverick() && jobToProc != NULL) {
         int idx = jobToProc->getId();        
-        int frac = (_jobs.size() >= 10) ? 10 : _jobs.size();
-        int rounded = int(double(_jobs.size())/frac)*frac;
+        int frac = (_jobsCount >= 10) ? 10 : _jobsCount;
+        int rounded = int(double(_jobsCount)/frac)*frac;
         int tenth = rounded / frac;        
         if (idx % tenth == 0) {
             double percent = double(idx-1) / rounded * 100 + 0.5;
@@ -81,9 +185,21 @@ void ProgObserver<JobContainer,pJob,rJob>::ReportJobDone(pJob job, rJob *res, QM
     CTP_LOG(logDEBUG,*(thread->getLogger()))
         << "Reporting job results" << flush;    
     // RESULTS, TIME, HOST
+    TALLY_JOB<JobContainer,pJob,rJob>(job, -1, _jobsAvailable, _hostJobs);
     job->SaveResults(res);    
     job->setTime(GenerateTime());
     job->setHost(GenerateHost(thread));
+    TALLY_JOB<JobContainer,pJob,rJob>(job, +1, _jobsAvailable, _hostJobs);
+    if (_asyncIO) {
+        boost::lock_guard<boost::mutex> lock(_ioMutex);
+        _jobsDone.push_back(job);
+    }
+    else if (_sqlJobs) {
+        JobContainer done;
+        done.push_back(job);
+        REPORT_JOBS<JobContainer,pJob,rJob>(done, _progFile);
+    }
+    else _jobsToSync.push_back(job);
     // PRINT PROGRESS BAR
     _jobsReported += 1;
     if (!thread->isMaverick())
@@ -108,78 +224,827 @@ template<typename JobContainer, typename pJob, typename rJob>
 string ProgObserver<JobContainer,pJob,rJob>::GenerateTime() {
     boost::posix_time::ptime now 
         = boost::posix_time::second_clock::local_time();
-    return (format("%1$s") % now.time_of_day()).str();  
+    // YYYY-MM-DDTHH:MM:SS: dated, so --report can bin across days
+    return boost::posix_time::to_iso_extended_string(now);  
 }
 
 
 template<typename JobContainer, typename pJob, typename rJob>
 void ProgObserver<JobContainer,pJob,rJob>::SyncWithProgFile(QMThread *thread) {
     
+    if (_sockFd >= 0) {
+        this->SyncWithServer(thread);
+        return;
+    }
+    if (_sqlJobs) {
+        this->SyncWithJobTable(thread);
+        return;
+    }
+    
     // INTERPROCESS FILE LOCKING (THREAD LOCK IN ::RequestNextJob)
     this->LockProgFile(thread);
     
-    string progFile = _progFile;
-    string progBackFile = _progFile+"~";
-    string tabFile = progFile;
-    boost::algorithm::replace_last(tabFile, ".xml", ".tab");
-    if (tabFile == progFile) tabFile += ".tab";
-    string tabBackFile = tabFile+"~";
+    string thisHost = GenerateHost(thread);
     
-    // LOAD EXTERNAL JOBS FROM SHARED XML & UPDATE INTERNAL JOBS
+    // REPLAY EXTERNAL RECORDS FROM JOURNAL & UPDATE INTERNAL JOBS
     CTP_LOG(logDEBUG,*(thread->getLogger()))
-        << "Update internal structures from job file" << flush;
-    JobContainer jobs_ext = LOAD_JOBS<JobContainer,pJob,rJob>(progFile);    
-    UPDATE_JOBS<JobContainer,pJob,rJob>(jobs_ext, _jobs, GenerateHost(thread));
+        << "Update internal structures from job journal" << flush;
+    string epoch = "";
+    string prev = "";
+    this->ReadJournalHeader(_journalFile, epoch, prev);
     
-    JobItVec it;
-    for (it = jobs_ext.begin(); it != jobs_ext.end(); ++it) {
-        pJob pj = *it;
-        delete pj;
+    if (epoch != _journalEpoch) {
+        // Compacted once since last sync => finish archived journal
+        if (epoch != "" && prev == _journalEpoch) {
+            REPLAY_JOBS<JobContainer,pJob,rJob>(_jobs, _journalFile+"~", 
+                _journalOffset, thisHost, _jobsAvailable, _hostJobs);
+        }
+        // Compacted repeatedly (or journal lost) => fall back to job file
+        else {
+            CTP_LOG(logDEBUG,*(thread->getLogger()))
+                << "Journal out of reach, reload job file" << flush;
+            JobContainer jobs_ext = LOAD_JOBS<JobContainer,pJob,rJob>(_progFile);
+            UPDATE_JOBS<JobContainer,pJob,rJob>(jobs_ext, _jobs, thisHost);
+            
+            JobItVec it;
+            for (it = jobs_ext.begin(); it != jobs_ext.end(); ++it) {
+                pJob pj = *it;
+                delete pj;
+            }
+            jobs_ext.clear();
+            this->CountJobs();
+        }
+        _journalEpoch = epoch;
+        _journalOffset = 0;
+        _journalRecords = 0;
+        if (epoch == "") this->StartJournal(thread);
     }
-    jobs_ext.clear();
-    
-    // GENERATE BACK-UP FOR SHARED XML
-    CTP_LOG(logDEBUG,*(thread->getLogger()))
-        << "Create job-file back-up" << flush;
-    WRITE_JOBS<JobContainer,pJob,rJob>(_jobs, progBackFile, "xml");
-    WRITE_JOBS<JobContainer,pJob,rJob>(_jobs, tabBackFile, "tab");
-    
+    _journalRecords += REPLAY_JOBS<JobContainer,pJob,rJob>(_jobs, _journalFile, 
+        _journalOffset, thisHost, _jobsAvailable, _hostJobs);
     
     // ASSIGN NEW JOBS IF AVAILABLE
     CTP_LOG(logDEBUG,*(thread->getLogger()))
         << "Assign jobs from stack" << flush;
     _jobsToProc.clear();
     
+    // Active hosts: this one and all that hold assigned jobs
+    int hosts = _hostJobs.size() + (_hostJobs.count(thisHost) ? 0 : 1);
+    
     unsigned int cacheSize = _cacheSize;
-    while (_jobsToProc.size() < cacheSize) {
-        if (_metajit == _jobs.end() || _startJobsCount == _maxJobs) break;
+    int n = this->AdaptCacheSize(std::max(_jobsAvailable, 0), hosts, thread);
+    if (_maxJobs >= 0 && _maxJobs - _startJobsCount < n) 
+        n = _maxJobs - _startJobsCount;
+    this->AssignJobs(_jobsToProc, n, thisHost);
+    _startJobsCount += _jobsToProc.size();
+    
+    // APPEND RESULTS & ASSIGNMENTS TO JOURNAL
+    _jobsToSync.insert(_jobsToSync.end(), _jobsToProc.begin(), _jobsToProc.end());
+    CTP_LOG(logDEBUG,*(thread->getLogger()))
+        << "Append " << _jobsToSync.size() << " records to job journal" << flush;
+    APPEND_JOBS<JobContainer,pJob,rJob>(_jobsToSync, _journalFile);
+    _journalOffset = boost::filesystem::file_size(_journalFile);
+    _journalRecords += _jobsToSync.size();
+    _jobsToSync.clear();
+    
+    // COMPACT JOURNAL INTO JOB FILE (AMORTIZED OVER ~N/4 RECORDS)
+    unsigned int maxRecords = _jobs.size()/4 + cacheSize;
+    if (_jobsToProc.size() == 0 || _journalRecords > int(maxRecords))
+        this->CompactProgFile(thread);
+
+    // RELEASE PROGRESS STATUS FILE
+    this->ReleaseProgFile(thread);
+    return;
+}
+
+
+template<typename JobContainer, typename pJob, typename rJob>
+void ProgObserver<JobContainer,pJob,rJob>::SyncWithJobTable(QMThread *thread) {
+    
+    // RESULTS ARE WRITTEN PER ROW ON REPORT, OR HERE WITH ASYNC I/O
+    if (_jobsToSync.size() > 0) {
+        JobContainer done(_jobsToSync.begin(), _jobsToSync.end());
+        REPORT_JOBS<JobContainer,pJob,rJob>(done, _progFile);
+        _jobsToSync.clear();
+    }
+    if (!_moreJobsAvailable) return;
+    
+    // NO FILE LOCK: CLAIMING IS ATOMIC WITHIN THE TABLE
+    CTP_LOG(logDEBUG,*(thread->getLogger()))
+        << "Claim jobs from job table" << flush;
+    _jobsToProc.clear();
+    
+    int available = 0;
+    int hosts = 1;
+    if (_syncInterval > 0.0) COUNT_JOBS<JobContainer,pJob,rJob>(_progFile, 
+        GenerateHost(thread), available, hosts);
+    int n = this->AdaptCacheSize(available, hosts, thread);
+    if (_maxJobs >= 0 && _maxJobs - _startJobsCount < n) 
+        n = _maxJobs - _startJobsCount;
+    if (n <= 0) return;
+    
+    JobContainer claimed = CLAIM_JOBS<JobContainer,pJob,rJob>(_progFile, n,
+        GenerateHost(thread), GenerateTime());
+    
+    // Claimed jobs are owned by this process from now on
+    JobItCnt it;
+    for (it = claimed.begin(); it != claimed.end(); ++it) {
+        _jobs.push_back(*it);
+        _jobsToProc.push_back(*it);
+        _startJobsCount += 1;
+    }
+    
+    CTP_LOG(logDEBUG,*(thread->getLogger()))
+        << "Claimed " << _jobsToProc.size() << " jobs" << flush;
+    return;
+}
+
+
+template<typename JobContainer, typename pJob, typename rJob>
+void ProgObserver<JobContainer,pJob,rJob>::AssignJobs(vector<pJob> &assigned, 
+    int n, string thisHost) {
+    
+    while (int(assigned.size()) < n) {
+        if (_metajit == _jobOrder.end()) break;
         
         bool startJob = false;
+        bool restart = false;
         
         // Start if job available or restart patterns matched
-        if ( ((*_metajit)->isAvailable())
-          || (_restartMode && _restart_stats.count((*_metajit)->getStatusStr()))
-          || (_restartMode && _restart_hosts.count((*_metajit)->getHost())) )
-            startJob = true;
+        if ((*_metajit)->isAvailable()) startJob = true;
+        else if (this->isRestart(*_metajit)) startJob = restart = true;
         
         if (startJob) {
+            // Restarts were counted as available by ::CountJobs
+            TALLY_JOB<JobContainer,pJob,rJob>(*_metajit, -1, _jobsAvailable, 
+                _hostJobs);
+            if (restart) _jobsAvailable -= 1;
             (*_metajit)->Reset();
             (*_metajit)->setStatus("ASSIGNED");
-            (*_metajit)->setHost(GenerateHost(thread));
+            (*_metajit)->setHost(thisHost);
             (*_metajit)->setTime(GenerateTime());
-            _jobsToProc.push_back(*_metajit);
-            _startJobsCount += 1;
+            TALLY_JOB<JobContainer,pJob,rJob>(*_metajit, +1, _jobsAvailable, 
+                _hostJobs);
+            assigned.push_back(*_metajit);
         }
 
         ++_metajit;
     }
+    return;
+}
+
+
+template<typename JobContainer, typename pJob, typename rJob>
+bool ProgObserver<JobContainer,pJob,rJob>::isRestart(pJob job) {
+    
+    return _restartMode && (_restart_stats.count(job->getStatusStr())
+                         || _restart_hosts.count(job->getHost()));
+}
+
+
+template<typename JobContainer, typename pJob, typename rJob>
+void ProgObserver<JobContainer,pJob,rJob>::CountJobs() {
+    
+    // FULL SCAN ON LOAD ONLY: REPLAY, ASSIGN & REPORT KEEP THE COUNTS
+    _jobsAvailable = 0;
+    _hostJobs.clear();
+    JobItCnt jit;
+    for (jit = _jobs.begin(); jit != _jobs.end(); ++jit)
+        TALLY_JOB<JobContainer,pJob,rJob>(*jit, +1, _jobsAvailable, _hostJobs);
+    for (jit = _metajit; jit != _jobOrder.end(); ++jit) {
+        if (!(*jit)->isAvailable() && this->isRestart(*jit)) 
+            _jobsAvailable += 1;
+    }
+    return;
+}
+
+
+template<typename JobContainer, typename pJob, typename rJob>
+int ProgObserver<JobContainer,pJob,rJob>::AdaptCacheSize(int remaining, 
+    int hosts, QMThread *thread) {
+    
+    if (_syncInterval <= 0.0) return _cacheSize;
+    
+    // THROUGHPUT: JOBS REPORTED PER SECOND SINCE LAST SYNC (SMOOTHED)
+    boost::posix_time::ptime now 
+        = boost::posix_time::microsec_clock::universal_time();
+    // Syncs run under _lockThread, as do reports (::ReportJobDone)
+    int reported = _jobsReported;
+    int done = reported - _lastReported;
+    if (!_lastSyncTime.is_not_a_date_time() && done > 0) {
+        double dt = (now - _lastSyncTime).total_milliseconds()/1000.;
+        if (dt > 0.0) {
+            double rate = done/dt;
+            _jobRate = (_jobRate > 0.0) ? 0.5*(_jobRate + rate) : rate;
+        }
+    }
+    _lastSyncTime = now;
+    _lastReported = reported;
+    
+    // ENOUGH JOBS TO LAST ONE SYNC INTERVAL (NO HISTORY YET: --cache)
+    int n = _cacheSize;
+    if (_jobRate > 0.0) n = int(std::ceil(_jobRate*_syncInterval));
+    
+    // TAIL: NO MORE THAN HALF THIS HOST'S SHARE OF THE JOBS LEFT (GUIDED
+    // SELF-SCHEDULING OVER THE ACTIVE HOSTS)
+    if (remaining >= 0) {
+        int share = remaining / (2*hosts);
+        if (n > share) n = share;
+    }
+    if (n < 1) n = 1;
+    
+    CTP_LOG(logDEBUG,*(thread->getLogger())) << "Cache size = " << n 
+        << (format(" (%1$1.2f jobs/s, %2$d hosts)") % _jobRate % hosts) << flush;
+    return n;
+}
+
+
+template<typename JobContainer, typename pJob, typename rJob>
+void ProgObserver<JobContainer,pJob,rJob>::StartIOThread(QMThread *thread) {
+    
+    if (!_asyncIO) return;
+    _jobsReady.clear();
+    _jobsDone.clear();
+    _jobsToProc.clear();
+    _nextjit = _jobsToProc.end();
+    _ioStop = false;
+    _ioDry = !_moreJobsAvailable;
+    _ioRequested = _moreJobsAvailable;
+    
+    CTP_LOG(logDEBUG,*(thread->getLogger())) << "Start I/O thread" << flush;
+    _ioThread = new IOThread(this, thread);
+    _ioThread->Start();
+    return;
+}
+
+
+template<typename JobContainer, typename pJob, typename rJob>
+void ProgObserver<JobContainer,pJob,rJob>::StopIOThread(QMThread *thread) {
+    
+    if (_ioThread == NULL) return;
+    {
+        boost::lock_guard<boost::mutex> lock(_ioMutex);
+        _ioStop = true;
+        _ioCond.notify_all();
+    }
+    _ioThread->WaitDone();
+    delete _ioThread;
+    _ioThread = NULL;
+    
+    // Results still queued go with the final sync
+    _jobsToSync.insert(_jobsToSync.end(), _jobsDone.begin(), _jobsDone.end());
+    _jobsDone.clear();
+    _jobsToProc.clear();
+    _nextjit = _jobsToProc.end();
+    CTP_LOG(logDEBUG,*(thread->getLogger())) << "Stopped I/O thread" << flush;
+    return;
+}
+
+
+template<typename JobContainer, typename pJob, typename rJob>
+void ProgObserver<JobContainer,pJob,rJob>::RunIOThread(QMThread *thread) {
+    
+    // Job threads do not touch _jobsToProc & _jobsToSync meanwhile
+    boost::unique_lock<boost::mutex> lock(_ioMutex);
+    while (true) {
+        while (!_ioRequested && !_ioStop) _ioCond.wait(lock);
+        if (_ioStop) break;
+        
+        _jobsToSync.insert(_jobsToSync.end(), _jobsDone.begin(), 
+            _jobsDone.end());
+        _jobsDone.clear();
+        lock.unlock();
+        
+        // Job threads save results into the same Job objects under
+        // _lockThread (::ReportJobDone), replay & compaction read them
+        _lockThread.Lock();
+        this->SyncWithProgFile(thread);
+        _lockThread.Unlock();
+        
+        lock.lock();
+        _jobsReady.insert(_jobsReady.end(), _jobsToProc.begin(), 
+            _jobsToProc.end());
+        if (_jobsToProc.size() == 0) {
+            _ioDry = true;
+            _moreJobsAvailable = false;
+            CTP_LOG(logDEBUG,*(thread->getLogger()))
+                << "Sync did not yield any new jobs." << flush;
+        }
+        _jobsToProc.clear();
+        _ioRequested = false;
+        _ioCond.notify_all();
+    }
+    return;
+}
+
+
+template<typename JobContainer, typename pJob, typename rJob>
+void ProgObserver<JobContainer,pJob,rJob>::OrderJobsByCost(QMThread *thread) {
+    
+    // HISTORY: MEAN WALL TIME PER TAG, WALL TIME PER INPUT SIZE OVERALL
+    map<string,double> tagTime;
+    map<string,int> tagCount;
+    double sumTime = 0.0;
+    double sumSize = 0.0;
+    JobItCnt it;
+    for (it = _jobOrder.begin(); it != _jobOrder.end(); ++it) {
+        if (!(*it)->hasWalltime()) continue;
+        tagTime[(*it)->getTag()] += (*it)->getWalltime();
+        tagCount[(*it)->getTag()] += 1;
+        sumTime += (*it)->getWalltime();
+        sumSize += (*it)->getInputSize();
+    }
+    double timePerSize = (sumSize > 0.0) ? sumTime/sumSize : 1.0;
+    
+    // ESTIMATE: OWN WALL TIME > COST HINT > TAG HISTORY > INPUT SIZE
+    vector< pair<double,int> > ranked;
+    int nTime = 0;
+    int nHint = 0;
+    int nTag = 0;
+    int nSize = 0;
+    for (unsigned int i = 0; i < _jobOrder.size(); ++i) {
+        pJob job = _jobOrder[i];
+        double cost = 0.0;
+        if (job->hasWalltime()) { 
+            cost = job->getWalltime(); ++nTime; }
+        else if (job->hasCost()) { 
+            cost = job->getCost(); ++nHint; }
+        else if (tagCount.count(job->getTag())) { 
+            cost = tagTime[job->getTag()]/tagCount[job->getTag()]; ++nTag; }
+        else { 
+            cost = timePerSize*job->getInputSize(); ++nSize; }
+        // Negative cost => longest first, ties remain in file order
+        ranked.push_back(pair<double,int>(-cost, i));
+    }
+    std::sort(ranked.begin(), ranked.end());
+    
+    JobContainer ordered;
+    for (unsigned int i = 0; i < ranked.size(); ++i) {
+        ordered.push_back(_jobOrder[ranked[i].second]);
+    }
+    _jobOrder = ordered;
+    
+    CTP_LOG(logINFO,*(thread->getLogger())) << "Ordered jobs by cost, "
+        << "estimated from wall time: " << nTime << ", hint: " << nHint 
+        << ", tag: " << nTag << ", input size: " << nSize << flush;
+    return;
+}
+
+
+template<typename JobContainer, typename pJob, typename rJob>
+void ProgObserver<JobContainer,pJob,rJob>::SyncWithServer(QMThread *thread) {
+    
+    // NO FILE LOCK: THE SERVER OWNS THE JOB FILE
+    string thisHost = GenerateHost(thread);
+    _jobsToProc.clear();
+    
+    int n = (_moreJobsAvailable) 
+        ? this->AdaptCacheSize(-1, 1, thread) : 0;
+    if (_maxJobs >= 0 && _maxJobs - _startJobsCount < n) 
+        n = _maxJobs - _startJobsCount;
+    if (n < 0) n = 0;
+    
+    // REPORT RESULTS & REQUEST NEW JOBS IN ONE GO
+    CTP_LOG(logDEBUG,*(thread->getLogger()))
+        << "Report " << _jobsToSync.size() << " results, request " << n 
+        << " jobs from server" << flush;
+    std::stringstream request;
+    request << "SYNC " << n << " " << thisHost << endl;
+    JobItVec it;
+    for (it = _jobsToSync.begin(); it != _jobsToSync.end(); ++it) {
+        (*it)->ToStream(request, "record");
+    }
+    _jobsToSync.clear();
+    
+    string reply = "";
+    if (!SEND_MESSAGE(_sockFd, request.str()) || !RECV_MESSAGE(_sockFd, reply))
+        throw runtime_error("Lost connection to job server on " + _sockFile);
+    
+    // REPLY: JOB COUNT, THEN ASSIGNED JOBS (OR "ERROR <what>")
+    size_t eol = reply.find('\n');
+    if (boost::algorithm::starts_with(reply, "ERROR"))
+        throw runtime_error("Job server on " + _sockFile + ": " 
+            + reply.substr(0, eol));
+    _jobsCount = boost::lexical_cast<int>(reply.substr(0, eol));
+    string jobsXml = (eol == string::npos) ? "" : reply.substr(eol+1);
+    if (jobsXml != "") {
+        std::istringstream iss("<jobs>" + jobsXml + "</jobs>");
+        JobContainer assigned;
+        JobReader reader;
+        reader.Read(iss, _sockFile, assigned);
+        
+        // Assigned jobs are owned by this process from now on
+        JobItCnt jit;
+        for (jit = assigned.begin(); jit != assigned.end(); ++jit) {
+            (*jit)->setHost(thisHost);
+            (*jit)->setTime(GenerateTime());
+            _jobs.push_back(*jit);
+            _jobsToProc.push_back(*jit);
+            _startJobsCount += 1;
+        }
+    }
+    
+    // FINAL SYNC => HANG UP
+    if (!_moreJobsAvailable) {
+        close(_sockFd);
+        _sockFd = -1;
+    }
+    return;
+}
+
+
+template<typename JobContainer, typename pJob, typename rJob>
+bool ProgObserver<JobContainer,pJob,rJob>::ConnectToServer(QMThread *thread) {
+    
+    if (!boost::filesystem::exists(_sockFile)) return false;
+    
+    struct sockaddr_un addr;
+    if (_sockFile.size() >= sizeof(addr.sun_path)) return false;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, _sockFile.c_str(), sizeof(addr.sun_path)-1);
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0) {
+        if (fd >= 0) close(fd);
+        CTP_LOG(logINFO,*(thread->getLogger())) << "No job server on "
+            << _sockFile << " (stale socket?), use file lock" << flush;
+        return false;
+    }
+    _sockFd = fd;
+    CTP_LOG(logINFO,*(thread->getLogger())) << "Connected to job server on "
+        << _sockFile << flush;
+    return true;
+}
+
+
+template<typename JobContainer, typename pJob, typename rJob>
+void ProgObserver<JobContainer,pJob,rJob>::Serve(QMThread *thread) {
+    
+    if (_sqlJobs) throw runtime_error("Job server requires an *.xml job file, "
+        "job tables are shared without a server.");
+    
+    // OWN THE JOB FILE FOR THE WHOLE SESSION
+    this->LockProgFile(thread);
+    
+    struct sockaddr_un addr;
+    if (_sockFile.size() >= sizeof(addr.sun_path))
+        throw runtime_error("Socket path too long: " + _sockFile);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, _sockFile.c_str(), sizeof(addr.sun_path)-1);
+    
+    unlink(_sockFile.c_str());
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0 
+     || bind(listenFd, (struct sockaddr*) &addr, sizeof(addr)) < 0
+     || listen(listenFd, SOMAXCONN) < 0)
+        throw runtime_error("Could not open job server socket " + _sockFile);
+    CTP_LOG(logINFO,*(thread->getLogger())) << "Serve " << _jobs.size() 
+        << " jobs on " << _sockFile << flush;
+    
+    // SERVE UNTIL STACK IS EMPTY AND ALL WORKERS HAVE HUNG UP
+    vector<struct pollfd> fds;
+    struct pollfd pfd;
+    pfd.fd = listenFd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    fds.push_back(pfd);
+    
+    int nRequests = 0;
+    while (_metajit != _jobOrder.end() || fds.size() > 1) {
+        if (poll(&fds[0], fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            throw runtime_error("Job server: poll failed");
+        }
+        for (unsigned int i = fds.size()-1; i > 0; --i) {
+            if (fds[i].revents == 0) continue;
+            string request = "";
+            bool alive = (fds[i].revents & POLLIN) 
+                && RECV_MESSAGE(fds[i].fd, request);
+            if (alive) {
+                // A bad request costs its client the connection, not the
+                // server its life
+                try {
+                    string reply = this->ServeRequest(request, thread);
+                    alive = SEND_MESSAGE(fds[i].fd, reply);
+                }
+                catch (std::exception &err) {
+                    CTP_LOG(logERROR,*(thread->getLogger())) 
+                        << "Job server: " << err.what() << flush;
+                    SEND_MESSAGE(fds[i].fd, string("ERROR ") + err.what());
+                    alive = false;
+                }
+                ++nRequests;
+            }
+            if (!alive) {
+                close(fds[i].fd);
+                fds.erase(fds.begin()+i);
+            }
+        }
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listenFd, NULL, NULL);
+            if (fd >= 0) {
+                pfd.fd = fd;
+                pfd.revents = 0;
+                fds.push_back(pfd);
+            }
+        }
+        _nClients = fds.size()-1;
+    }
+    
+    close(listenFd);
+    unlink(_sockFile.c_str());
+    CTP_LOG(logINFO,*(thread->getLogger())) << "Served " << nRequests 
+        << " requests, write job file" << flush;
+    
+    this->CompactProgFile(thread);
+    this->ReleaseProgFile(thread);
+    return;
+}
+
+
+template<typename JobContainer, typename pJob, typename rJob>
+string ProgObserver<JobContainer,pJob,rJob>::ServeRequest(const string &request,
+    QMThread *thread) {
+    
+    // REQUEST: "SYNC <n> <host>", THEN RESULT RECORDS
+    size_t eol = request.find('\n');
+    string header = request.substr(0, eol);
+    string records = (eol == string::npos) ? "" : request.substr(eol+1);
+    vector<string> split;
+    Tokenizer toker(header, " ");
+    toker.ToVector(split);
+    if (split.size() != 3 || split[0] != "SYNC")
+        throw runtime_error("Bad request '" + header + "'");
+    int n = 0;
+    try {
+        n = boost::lexical_cast<int>(split[1]);
+    }
+    catch (boost::bad_lexical_cast &) {
+        throw runtime_error("Bad job count in request '" + header + "'");
+    }
+    string host = split[2];
+    
+    // Workers adapt their request, the server caps it by the jobs left
+    if (_syncInterval > 0.0 && _nClients > 0) {
+        int share = std::max(_jobsAvailable, 0) / (2*_nClients);
+        if (n > share) n = (share > 0) ? share : 1;
+    }
+    
+    // Results go to the journal exactly as a worker would append them,
+    // once they parse: a broken record would break every later replay
+    if (records != "") {
+        std::istringstream iss("<jobs>" + records + "</jobs>");
+        vector<Job*> parsed;
+        JobReader reader;
+        reader.Read(iss, "request of " + host, parsed);
+        int unknown = -1;
+        vector<Job*> ::iterator pit;
+        for (pit = parsed.begin(); pit != parsed.end(); ++pit) {
+            int id = (*pit)->getId();
+            bool known = (id >= 1 && id <= int(_jobs.size()) 
+                && _jobs[id-1]->getId() == id);
+            for (JobItCnt jit = _jobs.begin(); 
+                jit != _jobs.end() && !known; ++jit) {
+                known = ((*jit)->getId() == id);
+            }
+            if (!known) unknown = id;
+            delete *pit;
+        }
+        if (unknown >= 0) 
+            throw runtime_error((format("Result for unknown job %1$d") 
+                % unknown).str());
+        
+        std::ofstream ofs;
+        ofs.open(_journalFile.c_str(), ofstream::out | ofstream::app);
+        if (!ofs.is_open()) {
+            throw runtime_error("Bad file handle: " + _journalFile);
+        }
+        ofs << records;
+        ofs.close();
+        _journalRecords += REPLAY_JOBS<JobContainer,pJob,rJob>(_jobs, 
+            _journalFile, _journalOffset, "", _jobsAvailable, _hostJobs);
+    }
+    
+    vector<pJob> assigned;
+    this->AssignJobs(assigned, n, host);
+    if (assigned.size()) {
+        APPEND_JOBS<JobContainer,pJob,rJob>(assigned, _journalFile);
+        _journalOffset = boost::filesystem::file_size(_journalFile);
+        _journalRecords += assigned.size();
+    }
+    CTP_LOG(logDEBUG,*(thread->getLogger())) << "Assign " << assigned.size()
+        << " jobs to " << host << flush;
+    
+    // COMPACT JOURNAL INTO JOB FILE (AMORTIZED OVER ~N/4 RECORDS)
+    unsigned int maxRecords = _jobs.size()/4 + _cacheSize;
+    if (_journalRecords > int(maxRecords)) 
+        this->CompactProgFile(thread);
+    
+    // REPLY: JOB COUNT, THEN ASSIGNED JOBS
+    std::stringstream reply;
+    reply << _jobs.size() << endl;
+    JobItVec it;
+    for (it = assigned.begin(); it != assigned.end(); ++it) {
+        (*it)->ToStream(reply, "xml");
+    }
+    return reply.str();
+}
+
+
+template<typename JobContainer, typename pJob, typename rJob>
+void ProgObserver<JobContainer,pJob,rJob>::WriteReport(QMThread *thread) {
+    
+    // Job tables are not held in memory => load
+    JobContainer loaded;
+    if (_sqlJobs) loaded = LOAD_JOBS<JobContainer,pJob,rJob>(_progFile);
+    JobContainer &jobs = (_sqlJobs) ? loaded : _jobs;
+    
+    map<string,int> statCount;
+    map<string,int> hostJobs;
+    map<string,double> hostTime;
+    map<string,int> hourJobs;
+    map<string,double> phaseTime;
+    vector< pair<double,int> > slowest;
+    double wallSum = 0.0;
+    double cpuSum = 0.0;
+    long rssMax = 0;
+    
+    for (unsigned int i = 0; i < jobs.size(); ++i) {
+        pJob job = jobs[i];
+        statCount[job->getStatusStr()] += 1;
+        if (!job->hasWalltime()) continue;
+        
+        double w = job->getWalltime();
+        wallSum += w;
+        if (job->hasCputime()) cpuSum += job->getCputime();
+        if (job->hasRss() && job->getRss() > rssMax) rssMax = job->getRss();
+        slowest.push_back(pair<double,int>(-w, i));
+        
+        // Hosts are HOSTNAME:PID, times YYYY-MM-DDTHH:MM:SS (older job
+        // files: HH:MM:SS, binned by hour of day only)
+        string host = (job->hasHost()) ? job->getHost() : "unknown";
+        host = host.substr(0, host.find(':'));
+        hostJobs[host] += 1;
+        hostTime[host] += w;
+        if (job->hasTime()) {
+            string time = job->getTime();
+            if (time.size() >= 13 && time[10] == 'T')
+                hourJobs[time.substr(0,10) + " " + time.substr(11,2)] += 1;
+            else
+                hourJobs["(undated) " + time.substr(0,2)] += 1;
+        }
+        
+        vector<string> split;
+        Tokenizer toker(job->getPhases(), " =");
+        toker.ToVector(split);
+        for (unsigned int p = 0; p+1 < split.size(); p += 2) {
+            phaseTime[split[p]] += boost::lexical_cast<double>(split[p+1]);
+        }
+    }
+    
+    map<string,int> ::iterator iit;
+    map<string,double> ::iterator dit;
+    
+    cout << endl << "Job report for " << _progFile << endl;
+    cout << endl << "Status" << endl;
+    for (iit = statCount.begin(); iit != statCount.end(); ++iit) {
+        cout << (format("  %1$-10s %2$8d") % iit->first % iit->second) << endl;
+    }
+    
+    cout << endl << (format("Resources (%1$d timed jobs)") % slowest.size()) 
+         << endl;
+    cout << (format("  Wall time    %1$12.1f s") % wallSum) << endl;
+    cout << (format("  CPU time     %1$12.1f s (job threads, w/o subthreads)") 
+        % cpuSum) << endl;
+    cout << (format("  Peak RSS     %1$12d kB (process, at job end)") % rssMax) 
+        << endl;
+    
+    cout << endl << "Throughput (completed per hour)" << endl;
+    for (iit = hourJobs.begin(); iit != hourJobs.end(); ++iit) {
+        cout << (format("  %1$13s:00 %2$8d") % iit->first % iit->second) << endl;
+    }
+    
+    cout << endl << "Hosts (jobs, wall time, jobs per thread-hour)" << endl;
+    for (iit = hostJobs.begin(); iit != hostJobs.end(); ++iit) {
+        double t = hostTime[iit->first];
+        cout << (format("  %1$-24s %2$8d %3$12.1f s %4$10.2f") % iit->first
+            % iit->second % t % ((t > 0.0) ? iit->second/t*3600. : 0.0)) 
+            << endl;
+    }
+    
+    cout << endl << "Phases (wall time, share of job wall time)" << endl;
+    for (dit = phaseTime.begin(); dit != phaseTime.end(); ++dit) {
+        cout << (format("  %1$-16s %2$12.1f s %3$6.1f%%") % dit->first
+            % dit->second % ((wallSum > 0.0) ? dit->second/wallSum*100 : 0.0))
+            << endl;
+    }
+    
+    cout << endl << "Slowest jobs (id, tag, host, wall time)" << endl;
+    std::sort(slowest.begin(), slowest.end());
+    for (unsigned int i = 0; i < slowest.size() && i < 10; ++i) {
+        pJob job = jobs[slowest[i].second];
+        cout << (format("  %1$8d %2$-24s %3$-24s %4$10.1f s") % job->getId()
+            % job->getTag() % ((job->hasHost()) ? job->getHost() : "unknown")
+            % job->getWalltime()) << endl;
+    }
+    
+    JobItCnt it;
+    for (it = loaded.begin(); it != loaded.end(); ++it) delete *it;
+    return;
+}
+
+
+template<typename JobContainer, typename pJob, typename rJob>
+void ProgObserver<JobContainer,pJob,rJob>::CompactProgFile(QMThread *thread) {
+    
+    // NOTE Caller holds the interprocess file lock
+    string progFile = _progFile;
+    string progBackFile = _progFile+"~";
+    string tabFile = progFile;
+    boost::algorithm::replace_last(tabFile, ".xml", ".tab");
+    if (tabFile == progFile) tabFile += ".tab";
+    string tabBackFile = tabFile+"~";
+    
+    CTP_LOG(logDEBUG,*(thread->getLogger()))
+        << "Compact " << _journalRecords << " journal records into job file"
+        << flush;
+    
+    // GENERATE BACK-UP FOR SHARED XML
+    if (boost::filesystem::exists(progFile)) {
+        if (boost::filesystem::exists(progBackFile)) 
+            boost::filesystem::remove(progBackFile);
+        boost::filesystem::copy_file(progFile, progBackFile);
+    }
+    if (boost::filesystem::exists(tabFile)) {
+        if (boost::filesystem::exists(tabBackFile)) 
+            boost::filesystem::remove(tabBackFile);
+        boost::filesystem::copy_file(tabFile, tabBackFile);
+    }
     
     // UPDATE PROGRESS STATUS FILE
     WRITE_JOBS<JobContainer,pJob,rJob>(_jobs, progFile, "xml");
     WRITE_JOBS<JobContainer,pJob,rJob>(_jobs, tabFile, "tab");
+    
+    // ARCHIVE JOURNAL FOR PROCESSES THAT HAVE NOT CAUGHT UP YET
+    boost::filesystem::rename(_journalFile, _journalFile+"~");
+    this->StartJournal(thread);
+    return;
+}
 
-    // RELEASE PROGRESS STATUS FILE
-    this->ReleaseProgFile(thread);
+
+template<typename JobContainer, typename pJob, typename rJob>
+void ProgObserver<JobContainer,pJob,rJob>::StartJournal(QMThread *thread) {
+    
+    // Epoch identifies this journal, previous epoch its archived predecessor
+    string epoch = (format("%1$s:%2$s") % GenerateHost(thread) 
+        % boost::posix_time::to_iso_string(
+            boost::posix_time::microsec_clock::universal_time())).str();
+    
+    std::ofstream ofs;
+    ofs.open(_journalFile.c_str(), ofstream::out);
+    if (!ofs.is_open()) {
+        throw runtime_error("Bad file handle: " + _journalFile);
+    }
+    ofs << (format("<!-- journal epoch=\"%1$s\" previous=\"%2$s\" -->\n")
+        % epoch % _journalEpoch).str();
+    ofs.close();
+    
+    _journalEpoch = epoch;
+    _journalOffset = boost::filesystem::file_size(_journalFile);
+    _journalRecords = 0;
+    
+    CTP_LOG(logDEBUG,*(thread->getLogger()))
+        << "Started job journal " << _journalFile << flush;
+    return;
+}
+
+
+template<typename JobContainer, typename pJob, typename rJob>
+void ProgObserver<JobContainer,pJob,rJob>::ReadJournalHeader(
+    const string &journal, string &epoch, string &prev) {
+    
+    epoch = "";
+    prev = "";
+    std::ifstream ifs;
+    ifs.open(journal.c_str(), ifstream::in);
+    if (!ifs.is_open()) return;
+    
+    // <!-- journal epoch="..." previous="..." -->
+    string header;
+    std::getline(ifs, header);
+    ifs.close();
+    
+    string::size_type pos = header.find("epoch=\"");
+    if (pos != string::npos) {
+        pos += 7;
+        epoch = header.substr(pos, header.find("\"", pos) - pos);
+    }
+    pos = header.find("previous=\"");
+    if (pos != string::npos) {
+        pos += 10;
+        prev = header.substr(pos, header.find("\"", pos) - pos);
+    }
     return;
 }
 
@@ -215,6 +1080,15 @@ void ProgObserver<JobContainer,pJob,rJob>
     _lockFile = optsMap["file"].as<string>();
     _cacheSize = optsMap["cache"].as<int>();
     _maxJobs = optsMap["maxjobs"].as<int>();
+    _serve = (optsMap.count("serve") > 0);
+    _report = (optsMap.count("report") > 0);
+    _nThreads = optsMap["nthreads"].as<int>();
+    _syncInterval = optsMap["sync-interval"].as<double>();
+    _asyncIO = (optsMap.count("async-io") > 0);
+    _order = optsMap["order"].as<string>();
+    if (_order != "file" && _order != "cost")
+        throw runtime_error("Job order '" + _order + "' not known, use "
+            "'file' or 'cost'");
     string restartPattern = optsMap["restart"].as<string>();
     
     // restartPattern = e.g. host(pckr124:1234) stat(FAILED)    
@@ -262,10 +1136,6 @@ void ProgObserver<JobContainer,pJob,rJob>::InitFromProgFile(string progFile,
     
     CTP_LOG(logINFO,*(thread->getLogger())) << "Initialize jobs from "
             << progFile << flush;    
-    CTP_LOG(logINFO,*(thread->getLogger())) << "Lock & load " << flush;
-    
-    // LOCK, READ INTO XML
-    this->LockProgFile(thread);  
     
     // ... Clear container
     JobItCnt it;
@@ -274,13 +1144,117 @@ void ProgObserver<JobContainer,pJob,rJob>::InitFromProgFile(string progFile,
         delete job;
     }
     _jobs.clear();
+    _jobOrder.clear();
+    
+    // JOB SERVER RUNNING? => CONNECT, JOBS ARE HANDED OUT ON SYNC
+    _sockFile = progFile;
+    boost::algorithm::replace_last(_sockFile, ".xml", ".sock");
+    if (_sockFile == progFile) _sockFile += ".sock";
+    if (!_serve && !_report && this->ConnectToServer(thread)) {
+        _jobsCount = 0;
+        _moreJobsAvailable = true;
+        return;
+    }
+    
+    CTP_LOG(logINFO,*(thread->getLogger())) << "Lock & load " << flush;
+    
+    // LOCK, READ INTO XML
+    this->LockProgFile(thread);  
+    
+    // ... Job table: claimed on demand, only import if not there yet
+    _sqlJobs = boost::algorithm::ends_with(progFile, ".sql");
+    if (_sqlJobs) {
+        if (!boost::filesystem::exists(progFile)) {
+            string xmlFile = progFile;
+            boost::algorithm::replace_last(xmlFile, ".sql", ".xml");
+            if (!boost::filesystem::exists(xmlFile))
+                throw runtime_error("Neither job table " + progFile 
+                    + " nor job file " + xmlFile + " found.");
+            CTP_LOG(logINFO,*(thread->getLogger())) << "Import jobs from "
+                 << xmlFile << flush;
+            JobContainer jobs_xml = LOAD_JOBS<JobContainer,pJob,rJob>(xmlFile);
+            WRITE_JOBS<JobContainer,pJob,rJob>(jobs_xml, progFile, "sql");
+            for (it = jobs_xml.begin(); it != jobs_xml.end(); ++it) {
+                pJob job = *it;
+                delete job;
+            }
+        }
+        JobDatabase db;
+        db.OpenHelper(progFile);
+        db.Exec("PRAGMA busy_timeout = 60000;");
+        
+        // ... Restart patterns are applied once, here, rather than per claim
+        if (_restartMode) {
+            db.Exec("BEGIN IMMEDIATE;");
+            map<string,bool> ::iterator mit;
+            string where = "";
+            for (mit = _restart_stats.begin(); mit != _restart_stats.end(); ++mit)
+                where += ((where == "") ? "" : ", ") + string("?");
+            where = (where == "") ? "0" : "status IN (" + where + ")";
+            string hosts = "";
+            for (mit = _restart_hosts.begin(); mit != _restart_hosts.end(); ++mit)
+                hosts += ((hosts == "") ? "" : ", ") + string("?");
+            if (hosts != "") where += " OR host IN (" + hosts + ")";
+            
+            Statement *reset = db.Prepare("UPDATE jobs SET status = 'AVAILABLE', "
+                "host = '', time = '', output = '', error = '' WHERE " + where);
+            int col = 1;
+            for (mit = _restart_stats.begin(); mit != _restart_stats.end(); ++mit)
+                reset->Bind(col++, mit->first);
+            for (mit = _restart_hosts.begin(); mit != _restart_hosts.end(); ++mit)
+                reset->Bind(col++, mit->first);
+            reset->InsertStep();
+            delete reset;
+            db.Exec("END;");
+        }
+        
+        Statement *stmt = db.Prepare("SELECT COUNT(*) FROM jobs;");
+        stmt->Step();
+        _jobsCount = stmt->Column<int>(0);
+        delete stmt;
+        db.Close();
+        
+        CTP_LOG(logINFO,*(thread->getLogger())) << "Registered " << _jobsCount
+             << " jobs in table." << flush;
+        _moreJobsAvailable = (_jobsCount > 0) ? true : false;
+        this->ReleaseProgFile(thread);
+        return;
+    }
 
     // ... Load new, set availability bool
     _jobs = LOAD_JOBS<JobContainer,pJob,rJob>(progFile);
-    _metajit = _jobs.begin();
+    _jobsCount = _jobs.size();
     WRITE_JOBS<JobContainer,pJob,rJob>(_jobs, progFile+"~", "xml");
     CTP_LOG(logINFO,*(thread->getLogger())) << "Registered " << _jobs.size()
          << " jobs." << flush;
+    
+    // ... Replay journal, unless it predates the job file (=> stale)
+    _journalFile = progFile;
+    boost::algorithm::replace_last(_journalFile, ".xml", ".journal");
+    if (_journalFile == progFile) _journalFile += ".journal";
+    string epoch = "";
+    string prev = "";
+    this->ReadJournalHeader(_journalFile, epoch, prev);
+    _journalEpoch = "";
+    if (epoch != "" && boost::filesystem::last_write_time(_journalFile)
+                    >= boost::filesystem::last_write_time(progFile)) {
+        _journalEpoch = epoch;
+        _journalOffset = 0;
+        _journalRecords = REPLAY_JOBS<JobContainer,pJob,rJob>(_jobs, 
+            _journalFile, _journalOffset, "", _jobsAvailable, _hostJobs);
+        CTP_LOG(logINFO,*(thread->getLogger())) << "Replayed "
+             << _journalRecords << " records from " << _journalFile << flush;
+    }
+    else {
+        this->StartJournal(thread);
+    }
+    
+    // ... Order in which jobs are handed out
+    _jobOrder = _jobs;
+    if (_order == "cost") this->OrderJobsByCost(thread);
+    _metajit = _jobOrder.begin();
+    this->CountJobs();
+    
 	if (_jobs.size()>0) _moreJobsAvailable = true;
 	else _moreJobsAvailable = false;
     
@@ -323,24 +1297,55 @@ JobContainer LOAD_JOBS(const string &job_file) {
     return jobcnt;
 }
 
+vector<Job*> JOBS_FROM_ROWS(Statement *stmt);
+
 template<>
 vector<Job*> LOAD_JOBS< vector<Job*>, Job*, Job::JobResult >(const string &job_file) {
     
-    vector<Job*> jobs;    
-    Property xml;
-    load_property_from_xml(xml, job_file);
+    vector<Job*> jobs;
     
-    list<Property*> jobProps = xml.Select("jobs.job");
-    list<Property*> ::iterator it;
-    for (it = jobProps.begin(); it != jobProps.end(); ++it) {
-        
-        Job *newJob = new Job(*it);
-        jobs.push_back(newJob);       
+    if (boost::algorithm::ends_with(job_file, ".sql")) {
+        JobDatabase db;
+        db.OpenHelper(job_file);
+        Statement *stmt = db.Prepare("SELECT id, tag, input, status, host, "
+            "time, output, error FROM jobs ORDER BY id;");
+        jobs = JOBS_FROM_ROWS(stmt);
+        delete stmt;
+        db.Close();
+        return jobs;
     }
     
+    // Stream jobs, inputs & outputs are parsed only when accessed
+    JobReader reader;
+    reader.Read(job_file, jobs);
+    
     return jobs;   
 }
 
+// Rebuilds jobs from job-table rows (id, tag, input, status, host, time,
+// output, error). Input and output stay XML text until accessed.
+vector<Job*> JOBS_FROM_ROWS(Statement *stmt) {
+    
+    vector<Job*> jobs;
+    while (stmt->Step() != SQLITE_DONE) {
+        int id = stmt->Column<int>(0);
+        string tag = stmt->Column<string>(1);
+        string no_input = "";
+        Job *job = new Job(id, tag, no_input, stmt->Column<string>(3));
+        job->setInputXml(stmt->Column<string>(2));
+        string host = stmt->Column<string>(4);
+        string time = stmt->Column<string>(5);
+        string output = stmt->Column<string>(6);
+        string error = stmt->Column<string>(7);
+        if (host != "") job->setHost(host);
+        if (time != "") job->setTime(time);
+        if (output != "") job->setOutputXml(output);
+        if (error != "") job->setError(error);
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
 template<typename JobContainer, typename pJob, typename rJob>
 void WRITE_JOBS(JobContainer &jobs, const string &job_file, string fileformat) {
     
@@ -354,6 +1359,48 @@ void WRITE_JOBS< vector<Job*>, Job*, Job::JobResult >(vector<Job*> &jobs,
     
     vector<Job*> ::iterator it;
     
+    if (fileformat == "sql") {
+        votca::tools::PropertyIOManipulator 
+            iomXML(votca::tools::PropertyIOManipulator::XML, 0, "\t\t");
+        
+        JobDatabase db;
+        db.OpenHelper(job_file);
+        db.Exec("PRAGMA busy_timeout = 60000;");
+        db.Exec("BEGIN IMMEDIATE;");
+        
+        // Rows of jobs already in the table are left alone, see REPORT_JOBS
+        Statement *insert = db.Prepare("INSERT OR IGNORE INTO jobs ("
+            "id, tag, input, status, host, time, output, error) "
+            "VALUES (?, ?, ?, ?, ?, ?, ?, ?)");
+        
+        for (it = jobs.begin(); it != jobs.end(); ++it) {
+            Job *job = *it;
+            
+            std::stringstream input;
+            input << iomXML << job->getInput();
+            std::stringstream output;
+            if (job->hasOutput()) {
+                Property out = job->getOutput();
+                output << iomXML << out;
+            }
+            insert->Bind(1, job->getId());
+            insert->Bind(2, job->getTag());
+            insert->Bind(3, input.str());
+            insert->Bind(4, job->getStatusStr());
+            insert->Bind(5, (job->hasHost()) ? job->getHost() : string(""));
+            insert->Bind(6, (job->hasTime()) ? job->getTime() : string(""));
+            insert->Bind(7, output.str());
+            insert->Bind(8, (job->hasError()) ? job->getError() : string(""));
+            insert->InsertStep();
+            insert->Reset();
+        }
+        
+        delete insert;
+        db.Exec("END;");
+        db.Close();
+        return;
+    }
+    
     std::ofstream ofs;
     ofs.open(job_file.c_str(), ofstream::out);
     if (!ofs.is_open()) {
@@ -370,6 +1417,54 @@ void WRITE_JOBS< vector<Job*>, Job*, Job::JobResult >(vector<Job*> &jobs,
     return;
 }
 
+template<typename JobContainer, typename pJob, typename rJob>
+void REPORT_JOBS(JobContainer &jobs, const string &job_file) {
+    
+    throw std::runtime_error("REPORT_JOBS not specialized for this type.");    
+    return;
+}
+
+template<>
+void REPORT_JOBS< vector<Job*>, Job*, Job::JobResult >(vector<Job*> &jobs, 
+        const string &job_file) {
+    
+    votca::tools::PropertyIOManipulator 
+        iomXML(votca::tools::PropertyIOManipulator::XML, 0, "\t\t");
+    
+    JobDatabase db;
+    db.OpenHelper(job_file);
+    db.Exec("PRAGMA busy_timeout = 60000;");
+    db.Exec("BEGIN IMMEDIATE;");
+    
+    // Status & results only: id, tag and input are in the row since import
+    Statement *update = db.Prepare("UPDATE jobs SET "
+        "status = ?, host = ?, time = ?, output = ?, error = ? "
+        "WHERE id = ?");
+    
+    vector<Job*> ::iterator it;
+    for (it = jobs.begin(); it != jobs.end(); ++it) {
+        Job *job = *it;
+        std::stringstream output;
+        if (job->hasOutput()) {
+            Property out = job->getOutput();
+            output << iomXML << out;
+        }
+        update->Bind(1, job->getStatusStr());
+        update->Bind(2, (job->hasHost()) ? job->getHost() : string(""));
+        update->Bind(3, (job->hasTime()) ? job->getTime() : string(""));
+        update->Bind(4, output.str());
+        update->Bind(5, (job->hasError()) ? job->getError() : string(""));
+        update->Bind(6, job->getId());
+        update->InsertStep();
+        update->Reset();
+    }
+    
+    delete update;
+    db.Exec("END;");
+    db.Close();
+    return;
+}
+
 template<typename JobContainer, typename pJob, typename rJob>
 void UPDATE_JOBS(JobContainer &from, JobContainer &to, string thisHost) {
     
@@ -406,6 +1501,204 @@ void UPDATE_JOBS< vector<Job*>, Job*, Job::JobResult >(vector<Job*> &from,
 
 
 
+template<typename JobContainer, typename pJob, typename rJob>
+JobContainer CLAIM_JOBS(const string &job_file, int n, string thisHost, 
+        string time) {
+    
+    throw std::runtime_error("CLAIM_JOBS not specialized for this type.");    
+    JobContainer jobcnt;
+    return jobcnt;
+}
+
+template<>
+vector<Job*> CLAIM_JOBS< vector<Job*>, Job*, Job::JobResult >(
+        const string &job_file, int n, string thisHost, string time) {
+    
+    JobDatabase db;
+    db.OpenHelper(job_file);
+    db.Exec("PRAGMA busy_timeout = 60000;");
+    
+    // Write lock for the whole claim => no two processes pick the same row
+    db.Exec("BEGIN IMMEDIATE;");
+    
+    Statement *select = db.Prepare("SELECT id, tag, input, status, host, "
+        "time, output, error FROM jobs WHERE status = 'AVAILABLE' "
+        "ORDER BY id LIMIT ?;");
+    select->Bind(1, n);
+    vector<Job*> jobs = JOBS_FROM_ROWS(select);
+    delete select;
+    
+    Statement *update = db.Prepare("UPDATE jobs SET status = 'ASSIGNED', "
+        "host = ?, time = ?, output = '', error = '' WHERE id = ?");
+    vector<Job*> ::iterator it;
+    for (it = jobs.begin(); it != jobs.end(); ++it) {
+        (*it)->Reset();
+        (*it)->setStatus(Job::ASSIGNED);
+        (*it)->setHost(thisHost);
+        (*it)->setTime(time);
+        update->Bind(1, thisHost);
+        update->Bind(2, time);
+        update->Bind(3, (*it)->getId());
+        update->InsertStep();
+        update->Reset();
+    }
+    delete update;
+    
+    db.Exec("END;");
+    db.Close();
+    return jobs;
+}
+
+template<typename JobContainer, typename pJob, typename rJob>
+void COUNT_JOBS(const string &job_file, string thisHost, int &available, 
+        int &hosts) {
+    
+    throw std::runtime_error("COUNT_JOBS not specialized for this type.");    
+    return;
+}
+
+template<>
+void COUNT_JOBS< vector<Job*>, Job*, Job::JobResult >(const string &job_file,
+        string thisHost, int &available, int &hosts) {
+    
+    JobDatabase db;
+    db.OpenHelper(job_file);
+    db.Exec("PRAGMA busy_timeout = 60000;");
+    
+    // Active hosts: this one and all others that hold assigned jobs
+    Statement *stmt = db.Prepare("SELECT "
+        "(SELECT COUNT(*) FROM jobs WHERE status = 'AVAILABLE'), "
+        "(SELECT COUNT(DISTINCT host) FROM jobs WHERE status = 'ASSIGNED' "
+        "AND host != ?);");
+    stmt->Bind(1, thisHost);
+    available = 0;
+    hosts = 1;
+    if (stmt->Step() == SQLITE_ROW) {
+        available = stmt->Column<int>(0);
+        hosts += stmt->Column<int>(1);
+    }
+    delete stmt;
+    db.Close();
+    return;
+}
+
+template<typename JobContainer, typename pJob, typename rJob>
+void APPEND_JOBS(vector<pJob> &jobs, const string &journal_file) {
+    
+    throw std::runtime_error("APPEND_JOBS not specialized for this type.");    
+    return;
+}
+
+template<>
+void APPEND_JOBS< vector<Job*>, Job*, Job::JobResult >(vector<Job*> &jobs, 
+        const string &journal_file) {
+    
+    vector<Job*> ::iterator it;
+    
+    std::ofstream ofs;
+    ofs.open(journal_file.c_str(), ofstream::out | ofstream::app);
+    if (!ofs.is_open()) {
+        throw runtime_error("Bad file handle: " + journal_file);
+    }
+    for (it = jobs.begin(); it != jobs.end(); ++it) {
+        (*it)->ToStream(ofs, "record");
+    }
+    
+    ofs.close();
+    return;
+}
+
+template<typename JobContainer, typename pJob, typename rJob>
+void TALLY_JOB(pJob job, int sign, int &available, map<string,int> &hosts) {
+    
+    throw std::runtime_error("TALLY_JOB not specialized for this type.");
+    return;
+}
+
+template<>
+void TALLY_JOB< vector<Job*>, Job*, Job::JobResult >(Job *job, int sign, 
+        int &available, map<string,int> &hosts) {
+    
+    // Adds (+1) or removes (-1) the job from the available count and from 
+    // the count of jobs assigned to its host; hosts without any are dropped
+    if (job->isAvailable()) available += sign;
+    if (job->isAssigned() && job->hasHost()) {
+        int &assigned = hosts[job->getHost()];
+        assigned += sign;
+        if (assigned <= 0) hosts.erase(job->getHost());
+    }
+    return;
+}
+
+template<typename JobContainer, typename pJob, typename rJob>
+int REPLAY_JOBS(JobContainer &jobs, const string &journal_file, long &offset, 
+        string thisHost, int &available, map<string,int> &hosts) {
+    
+    throw std::runtime_error("REPLAY_JOBS not specialized for this type.");    
+    return 0;
+}
+
+template<>
+int REPLAY_JOBS< vector<Job*>, Job*, Job::JobResult >(vector<Job*> &jobs, 
+        const string &journal_file, long &offset, string thisHost, 
+        int &available, map<string,int> &hosts) {
+    
+    // READ RECORDS APPENDED SINCE OFFSET
+    std::ifstream ifs;
+    ifs.open(journal_file.c_str(), ifstream::in | ifstream::binary);
+    if (!ifs.is_open()) return 0;
+    ifs.seekg(0, ifstream::end);
+    long size = ifs.tellg();
+    if (size <= offset) return 0;
+    
+    string chunk(size-offset, ' ');
+    ifs.seekg(offset, ifstream::beg);
+    ifs.read(&chunk[0], size-offset);
+    ifs.close();
+    offset = size;
+    
+    // PARSE RECORDS IN MEMORY
+    std::istringstream iss("<jobs>" + chunk + "</jobs>");
+    vector<Job*> records;
+    JobReader reader;
+    reader.Read(iss, journal_file, records);
+    
+    // APPLY RECORDS OF OTHER HOSTS
+    bool in_sync = true;
+    vector<Job*> ::iterator it;
+    for (it = records.begin(); it != records.end() && in_sync; ++it) {
+        
+        Job *rec = *it;
+        if (rec->hasHost() && rec->getHost() == thisHost) continue;
+        
+        // Job files list ids 1 ... N in order; search otherwise
+        int id = rec->getId();
+        Job *job = NULL;
+        if (id >= 1 && id <= int(jobs.size()) && jobs[id-1]->getId() == id)
+            job = jobs[id-1];
+        else {
+            vector<Job*> ::iterator jit;
+            for (jit = jobs.begin(); jit != jobs.end(); ++jit) {
+                if ((*jit)->getId() == id) { job = *jit; break; }
+            }
+        }
+        if (job == NULL) in_sync = false;
+        else {
+            TALLY_JOB< vector<Job*>, Job*, Job::JobResult >(job, -1, 
+                available, hosts);
+            job->UpdateFromRecord(rec);
+            TALLY_JOB< vector<Job*>, Job*, Job::JobResult >(job, +1, 
+                available, hosts);
+        }
+    }
+    
+    int n_records = records.size();
+    for (it = records.begin(); it != records.end(); ++it) delete *it;
+    if (!in_sync)
+        throw runtime_error("Job journal out of sync (::id), abort.");
+    return n_records;
+}
+
 
 // REGISTER
 template class ProgObserver< vector<Job*>, Job*, Job::JobResult >;
@@ -20,10 +20,20 @@
 
 #include <votca/ctp/qmnblist.h>
 #include <votca/tools/globals.h>
+#include <votca/tools/mutex.h>
 #include <votca/ctp/topology.h>
+#include <votca/ctp/qmthread.h>
+#include <algorithm>
 
 namespace votca { namespace ctp {
 
+
+static std::pair<Segment*, Segment*> PairKey(Segment *seg1, Segment *seg2) {
+    return (seg1 < seg2) ? std::make_pair(seg1, seg2) 
+                         : std::make_pair(seg2, seg1);
+}
+
+
 QMPair *QMNBList::Add(Segment* seg1, Segment* seg2,bool safe) {
     
     if (safe){
@@ -37,12 +47,37 @@ QMPair *QMNBList::Add(Segment* seg1, Segment* seg2,bool safe) {
     QMPair *pair = new QMPair(id, seg1, seg2);
 
     this->AddPair(pair);
+    _pairIndex[PairKey(seg1, seg2)] = pair;
 
     return pair;
     
 }
 
 
+QMPair *QMNBList::FindPair(Segment* seg1, Segment* seg2) {
+    std::unordered_map< std::pair<Segment*, Segment*>, QMPair*, 
+        SegmentPairHash >::iterator it = _pairIndex.find(PairKey(seg1, seg2));
+    return (it != _pairIndex.end()) ? it->second : NULL;
+}
+
+
+void QMNBList::Cleanup() {
+    CSG::PairList<Segment*, QMPair>::Cleanup();
+    _pairIndex.clear();
+    this->setSuperExchangeTypes(std::list<SuperExchangeType*>());
+}
+
+
+void QMNBList::setSuperExchangeTypes(std::list<SuperExchangeType*> types) {
+    std::list<SuperExchangeType*>::iterator it;
+    for (it = _superexchange.begin(); it != _superexchange.end(); ++it) {
+        if (std::find(types.begin(), types.end(), *it) == types.end()) 
+            delete *it;
+    }
+    _superexchange = types;
+}
+
+
 void QMNBList::PrintInfo(FILE *out) {
 
     QMNBList::iterator nit;
@@ -71,9 +106,113 @@ void QMNBList::PrintInfo(FILE *out) {
 }
 
 
-void QMNBList::GenerateSuperExchange() {
+// Superexchange candidate: seg1 and seg2 (donor/acceptor) bridged by bridge
+struct BridgedPair
+{
+    Segment *seg1;
+    Segment *seg2;
+    Segment *bridge;
+};
+
+
+// Collects the bridged pairs of chunks of segments; the pair list is only
+// read, pairs are created in the merge of GenerateSuperExchange
+class BridgeSearch : public QMThread
+{
+public:
+
+    BridgeSearch(QMNBList *nblist, QMNBList::SuperExchangeType *type,
+        vector<Segment*> *segments, int chunkSize, int *nextChunk,
+        Mutex *mutex, vector< vector<BridgedPair> > *chunks)
+        : _nblist(nblist), _type(type), _segments(segments),
+          _chunkSize(chunkSize), _nextChunk(nextChunk), _mutex(mutex),
+          _chunks(chunks) { ; }
+   ~BridgeSearch() { ; }
+
+    void Run(void) {
+        while (true) {
+            _mutex->Lock();
+            int chunk = (*_nextChunk)++;
+            _mutex->Unlock();
+            if (chunk >= int(_chunks->size())) break;
+
+            int end = std::min(int(_segments->size()), (chunk+1)*_chunkSize);
+            for (int s = chunk*_chunkSize; s < end; ++s) {
+                this->Collect((*_segments)[s], (*_chunks)[chunk]);
+            }
+        }
+    }
+
+    void Collect(Segment *segment, vector<BridgedPair> &bridged) {
 
-    //QMNBList bridged_nblist;
+        // check if this is a bridge
+        if (!_type->isOfBridge(segment->getName())) return;
+
+        QMNBList::partners *_partners = _nblist->FindPartners(segment);
+        if (_partners == NULL) return;
+
+        // neighbors of the donor or acceptor type, ordered by id
+        map< int, Segment*> _neighbors;
+        QMNBList::partners::iterator itp;
+        for (itp = _partners->begin(); itp != _partners->end(); itp++) {
+            Segment *nb = itp->first;
+            if (_type->isOfDonorAcceptor(nb->getName())) {
+                _neighbors[ nb->getId() ] = nb;
+            }
+        }
+
+        // new pairs if there are more than one neighbors of DA type
+        if (_neighbors.size() < 2) return;
+        for (map<int, Segment*>::iterator it1 = _neighbors.begin(); it1 != _neighbors.end(); it1++) {
+            map<int, Segment*>::iterator it_diag = it1;
+            for (map<int, Segment*>::iterator it2 = ++it_diag; it2 != _neighbors.end(); it2++) {
+                BridgedPair bp = { it1->second, it2->second, segment };
+                bridged.push_back(bp);
+            }
+        }
+    }
+
+private:
+
+    QMNBList *_nblist;
+    QMNBList::SuperExchangeType *_type;
+    vector<Segment*> *_segments;
+    int _chunkSize;
+    int *_nextChunk;
+    Mutex *_mutex;
+    vector< vector<BridgedPair> > *_chunks;
+};
+
+
+// Creates or flags the pairs of bridged, in order
+static void MergeBridged(QMNBList &nblist, vector<BridgedPair> &bridged,
+    int &bridged_pairs, int &bridged_and_direct_pairs) {
+
+    for (unsigned int i = 0; i < bridged.size(); ++i) {
+        BridgedPair &bp = bridged[i];
+
+        QMPair *pair = nblist.FindPair(bp.seg1, bp.seg2);
+
+        if (pair == NULL ) { // no connection between donor and acceptor
+            QMPair* _pair = nblist.Add(bp.seg1, bp.seg2, false);
+            _pair->setType( QMPair::SuperExchange );
+            _pair->AddBridgingSegment( bp.bridge );
+            bridged_pairs++;
+        } else { // pair type is already there 
+            if ( pair->getType() == QMPair::Hopping ) {
+                bridged_and_direct_pairs++;
+                pair->setType( QMPair::SuperExchangeAndHopping );
+            }
+            pair->AddBridgingSegment( bp.bridge );
+        }
+    }
+}
+
+
+void QMNBList::GenerateSuperExchange(int nThreads) {
+
+    if (nThreads < 1) nThreads = 1;
+    vector<Segment*> &segments = _top->Segments();
 
     // loop over all donor/acceptor pair types
     for (std::list<SuperExchangeType*>::iterator itDA = _superexchange.begin(); itDA != _superexchange.end(); itDA++) {
@@ -81,58 +220,48 @@ void QMNBList::GenerateSuperExchange() {
         cout << endl << " ... ... Processing superexchange pairs of type " << (*itDA)->asString() << "\n" << flush;
         int _bridged_pairs = 0;
         int _bridged_and_direct_pairs = 0;
-        //int bridged_molecules = 0;
-
-        // vector of neighboring segments of the donor/acceptor type
-        map< int, Segment*> _ns;
-
-        // loop over all segments in the topology
-        for (std::vector< Segment* >::iterator segit = _top->Segments().begin(); segit != _top->Segments().end(); segit++) {
-
-            // check if this is a bridge
-            Segment* segment = *segit;
-            string name = segment->getName();
-
-            if ((*itDA)->isOfBridge(name)) {
-                QMNBList::partners *_partners = FindPartners(segment);
-
-                // loop over all partners of a segment
-                QMNBList::partners::iterator itp;
-                if (_partners != NULL) {
-                    map< int, Segment*> _neighbors;
-                    for (itp = _partners->begin(); itp != _partners->end(); itp++) {
-                        Segment *nb = itp->first;
-                        //QMPair *pair = itp->second;
-                        // check if the neighbor is of a donor or acceptor type
-                        if ((*itDA)->isOfDonorAcceptor(nb->getName())) _neighbors[ nb->getId() ] = nb;
-                    } // end of the loop of all partners of a segment
-
-                     // create new pairs if there are more than one neighbors of DA type
-                    if (_neighbors.size() > 1) {
-                        for (map<int, Segment*>::iterator it1 = _neighbors.begin(); it1 != _neighbors.end(); it1++) {
-                            map<int, Segment*>::iterator it_diag = it1;
-                            for (map<int, Segment*>::iterator it2 = ++it_diag; it2 != _neighbors.end(); it2++) {
-                                
-                                QMPair *pair = FindPair(it1->second, it2->second);
-                                
-                                if (pair == NULL ) { // no connection between donor and acceptor
-                                    QMPair* _pair = Add(it1->second, it2->second);
-                                    _pair->setType( QMPair::SuperExchange );
-                                    _pair->AddBridgingSegment( segment );                                   
-                                    _bridged_pairs++;
-                                } else { // pair type is already there 
-                                    if ( pair->getType() == QMPair::Hopping ) {
-                                        _bridged_and_direct_pairs++;
-                                        pair->setType( QMPair::SuperExchangeAndHopping );
-                                    }
-                                    pair->AddBridgingSegment( segment );
-                                }
-                            }
-                        }
-                    } // 
-                } // end of the check of zero partners
-            } // end of if this is a bridged pair
-        } // end of the loop of all segments
+
+        // Bridges that are donors/acceptors themselves see the pairs created
+        // for the bridges before them: collect and merge one at a time
+        if ((*itDA)->bridgesDonorAcceptor()) {
+            BridgeSearch search(this, *itDA, NULL, 0, NULL, NULL, NULL);
+            vector<BridgedPair> bridged;
+            for (unsigned int s = 0; s < segments.size(); ++s) {
+                bridged.clear();
+                search.Collect(segments[s], bridged);
+                MergeBridged(*this, bridged, _bridged_pairs, 
+                    _bridged_and_direct_pairs);
+            }
+            continue;
+        }
+
+        // Otherwise collect the bridged pairs of all bridges in parallel ...
+        const int chunkSize = 256;
+        vector< vector<BridgedPair> > chunks(
+            (segments.size() + chunkSize - 1) / chunkSize);
+        int nextChunk = 0;
+        Mutex mutex;
+
+        vector<BridgeSearch*> searches;
+        for (int id = 0; id < nThreads; id++) {
+            searches.push_back(new BridgeSearch(this, *itDA, &segments,
+                chunkSize, &nextChunk, &mutex, &chunks));
+        }
+        for (int id = 0; id < nThreads; id++) {
+            searches[id]->Start();
+        }
+        for (int id = 0; id < nThreads; id++) {
+            searches[id]->WaitDone();
+        }
+        for (int id = 0; id < nThreads; id++) {
+            delete searches[id];
+        }
+
+        // ... and merge them in segment order, as the serial loop would
+        for (unsigned int c = 0; c < chunks.size(); ++c) {
+            MergeBridged(*this, chunks[c], _bridged_pairs, 
+                _bridged_and_direct_pairs);
+        }
         
         //cout << "Added " << _bridged_pairs + _bridged_and_direct_pairs << " superexchange with " << _bridged_and_direct_pairs << " mixed pairs" << endl;     
        
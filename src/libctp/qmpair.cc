@@ -42,7 +42,8 @@ QMPair::QMPair(int id, Segment *seg1, Segment *seg2)
           _rate12_t(0), _rate21_t(0),
           _has_s(false), _has_t(false),       
           _lambdaO_s(0), _lambdaO_t(0),
-          _Jeff2_s(0),   _Jeff2_t(0),_pair_type( Hopping ) {
+          _Jeff2_s(0),   _Jeff2_t(0),_pair_type( Hopping ),
+          _dirty(DIRTY_ALL) {
 
     _top = seg1->getTopology();
 
@@ -102,6 +103,7 @@ vec QMPair::getR() {
 
 
 void QMPair::setLambdaO(double lO, int state) {  
+    _dirty |= DIRTY_LAMBDA;
     if (state ==-1) _lambdaO_e = lO;
     else if (state ==+1) _lambdaO_h = lO;
     else if (state ==+2) _lambdaO_s = lO;
@@ -110,6 +112,7 @@ void QMPair::setLambdaO(double lO, int state) {
 }
 
 void QMPair::setRate12(double rate, int state) {
+    _dirty |= DIRTY_RATES;
     if (state ==-1) _rate12_e = rate;
     else if (state ==+1) _rate12_h = rate;
     else if (state ==+2) _rate12_s = rate;
@@ -118,6 +121,7 @@ void QMPair::setRate12(double rate, int state) {
 }
 
 void QMPair::setRate21(double rate, int state) {
+    _dirty |= DIRTY_RATES;
     if (state ==-1) _rate21_e = rate;
     else if (state ==+1) _rate21_h = rate;
     else if (state ==+2) _rate21_s = rate;
@@ -126,6 +130,7 @@ void QMPair::setRate21(double rate, int state) {
 }
 
 void QMPair::setIsPathCarrier(bool yesno, int carrier) {
+    _dirty |= DIRTY_CARRIERS;
     if (carrier == -1)_has_e = yesno;
     else if (carrier == +1)_has_h = yesno;
     else if (carrier == +2)_has_s = yesno;
@@ -145,6 +150,7 @@ bool QMPair::isPathCarrier(int carrier) {
 
 //only izindo uses this 
 void QMPair::setJs(const std::vector<double> Js, int state) {
+    _dirty |= DIRTY_JEFF2;
     std::vector <double> ::const_iterator it;
     double Jeff2 = 0.0;
     if (state == -1) {
@@ -170,6 +176,7 @@ void QMPair::setJs(const std::vector<double> Js, int state) {
 
 void QMPair::setJeff2(double Jeff2, int state) {
 
+    _dirty |= DIRTY_JEFF2;
     if (state == -1) {
         _Jeff2_e = Jeff2;
     }
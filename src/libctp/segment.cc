@@ -25,7 +25,8 @@ namespace votca { namespace ctp {
    
 /// Default constructor
 Segment::Segment(int id, string name)
-        : _id(id),        _name(name),
+        : _id(id),        _name(name),   _nameId(NameTable::SegmentId(name)),
+          _dirty(DIRTY_ALL),
           _has_e(false),  _has_h(false),_has_s(false),  _has_t(false)
             { _eMpoles.resize(5); }
 
@@ -35,6 +36,8 @@ Segment::Segment(int id, string name)
 // be able to access it. Used for creating the ghost in PB corrected pairs.
 Segment::Segment(Segment *stencil)
         : _id(stencil->getId()),    _name(stencil->getName()+"_ghost"),
+          _nameId(NameTable::SegmentId(_name)),
+          _dirty(DIRTY_ALL),
           _typ(stencil->getType()), _top(NULL), _mol(NULL),
           _CoM(stencil->getPos()),
           _has_e(false), _has_h(false),_has_s(false),  _has_t(false)
@@ -73,6 +76,18 @@ Segment::~Segment() {
     _polarSites.clear();
 }
 
+void Segment::ResetState() {
+
+    _has_e = _has_h = _has_s = _has_t = false;
+    _occ_e = _occ_h = 0.0;
+    _occ_s = _occ_t = false;
+    _U_xX_nN_s = _U_xX_nN_t = 0.0;
+    _U_nX_nN_s = _U_nX_nN_t = 0.0;
+    _U_xN_xX_s = _U_xN_xX_t = 0.0;
+    _eMpoles.assign(5, 0.0);
+    _hasChrgState.clear();
+}
+
 void Segment::TranslateBy(const vec &shift) {
 
     _CoM = _CoM + shift;
@@ -88,6 +103,8 @@ void Segment::TranslateBy(const vec &shift) {
 
 
 void Segment::setHasState(bool yesno, int state) {
+    
+    _dirty |= DIRTY_STATES;
 
     if (state == -1) {
         _has_e = yesno;
@@ -128,6 +145,7 @@ bool Segment::hasState(int state) {
 
 void Segment::setOcc(double occ, int e_h_s_t) {
     
+    _dirty |= DIRTY_OCC;
     if (e_h_s_t == -1) {
         _occ_e = occ;
     }
@@ -166,6 +184,8 @@ void Segment::setOcc(double occ, int e_h_s_t) {
 }
     
 void Segment::setU_cC_nN(double dU, int state) {
+    
+    _dirty |= DIRTY_U;
 
     if (state == -1) {
         _U_cC_nN_e = dU;
@@ -180,6 +200,8 @@ void Segment::setU_cC_nN(double dU, int state) {
 
 
 void Segment::setU_nC_nN(double dU, int state) {
+    
+    _dirty |= DIRTY_U;
 
     if (state == -1) {
         _U_nC_nN_e = dU;
@@ -194,6 +216,8 @@ void Segment::setU_nC_nN(double dU, int state) {
 
 
 void Segment::setU_cN_cC(double dU, int state) {
+    
+    _dirty |= DIRTY_U;
 
     if (state == -1) {
         _U_cN_cC_e = dU;
@@ -305,6 +329,7 @@ double Segment::getSiteEnergy(int state) {
 
 void Segment::setEMpoles(int state, double energy) {
 
+    _dirty |= DIRTY_EMPOLES;
     _hasChrgState.resize(5);
     _hasChrgState[state+1] = true;
     _eMpoles[state+1] = energy;
@@ -20,11 +20,182 @@
 
 #include <votca/ctp/sqlapplication.h>
 #include <votca/ctp/calculatorfactory.h>
+#include <votca/ctp/parallelpaircalc.h>
+#include <votca/ctp/qmthread.h>
 #include <votca/ctp/version.h>
 #include <boost/format.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <deque>
 
 namespace votca { namespace ctp {
 
+
+// Pipelined frames (--prefetch, --frame-threads): an I/O thread reads the
+// next and saves the previous frames into/from spare topologies while the
+// calculators work on the current one(s). Reads and writes share the one
+// state saver (and SQLite connection) and hence take turns, writes first as
+// they free the topologies to read into. The first nskip frames read are
+// dropped right away.
+class FramePipeline : public QMThread
+{
+public:
+
+    FramePipeline(StateSaverSQLite &statsav, vector<Topology*> &tops, 
+        int nskip, int nread) : _statsav(statsav), _nskip(nskip), 
+        _nread(nread), _readDone(false), _finish(false) {
+        _free.insert(_free.end(), tops.begin(), tops.end());
+    }
+
+    // Next frame read, NULL once the state file or nread is exhausted
+    Topology *NextFrame() {
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        while (_ready.empty() && !_readDone) _cond.wait(lock);
+        if (!_error.empty()) throw runtime_error(_error);
+        if (_ready.empty()) return NULL;
+        Topology *top = _ready.front();
+        _ready.pop_front();
+        return top;
+    }
+
+    // Hands a processed frame back, to be saved first if requested
+    void Done(Topology *top, bool save) {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        if (save) _write.push_back(top);
+        else _free.push_back(top);
+        _cond.notify_all();
+    }
+
+    // Stops reading, waits for the pending writes
+    void Finish() {
+        {
+            boost::lock_guard<boost::mutex> lock(_mutex);
+            _finish = true;
+            _cond.notify_all();
+        }
+        this->WaitDone();
+        if (!_error.empty()) throw runtime_error(_error);
+    }
+
+    void Run(void) {
+        try {
+            this->IOLoop();
+        }
+        catch (std::exception &ex) {
+            boost::lock_guard<boost::mutex> lock(_mutex);
+            _error = ex.what();
+            _readDone = true;
+            _cond.notify_all();
+        }
+    }
+
+private:
+
+    void IOLoop() {
+        while (true) {
+            Topology *top = NULL;
+            bool write = false;
+            {
+                boost::unique_lock<boost::mutex> lock(_mutex);
+                while (_write.empty() && !_finish
+                    && (_readDone || _free.empty())) _cond.wait(lock);
+                if (!_write.empty()) {
+                    top = _write.front();
+                    _write.pop_front();
+                    write = true;
+                }
+                else if (!_finish && !_readDone && !_free.empty()) {
+                    top = _free.front();
+                    _free.pop_front();
+                }
+                else {
+                    _readDone = true;
+                    _cond.notify_all();
+                    return;
+                }
+            }
+
+            _statsav.setTopology(*top);
+            bool read = false;
+            if (write) {
+                _statsav.WriteFrame();
+            }
+            else if (_nread > 0) {
+                _nread -= 1;
+                read = _statsav.NextFrame();
+            }
+
+            boost::lock_guard<boost::mutex> lock(_mutex);
+            if (read && _nskip > 0) {
+                _nskip -= 1;
+                _free.push_back(top);
+            }
+            else if (read) {
+                _ready.push_back(top);
+            }
+            else {
+                if (!write) _readDone = true;
+                _free.push_back(top);
+            }
+            _cond.notify_all();
+        }
+    }
+
+    StateSaverSQLite &_statsav;
+    int _nskip;
+    int _nread;
+
+    boost::mutex _mutex;
+    boost::condition_variable _cond;
+    std::deque<Topology*> _free;
+    std::deque<Topology*> _ready;
+    std::deque<Topology*> _write;
+    bool _readDone;
+    bool _finish;
+    string _error;
+};
+
+
+// Evaluates frames off the pipeline, one of --frame-threads
+class FrameWorker : public QMThread
+{
+public:
+
+    FrameWorker(SqlApplication *app, FramePipeline *pipeline, bool save)
+        : _app(app), _pipeline(pipeline), _save(save), _framesDone(0) { ; }
+
+    void Run(void) {
+        try {
+            Topology *top = NULL;
+            while ((top = _pipeline->NextFrame()) != NULL) {
+                cout << "Evaluating frame " << top->getDatabaseId() << endl;
+                _app->EvaluateFrame(top);
+                if (!_save) {
+                    cout << "Changes have not been written to state file." 
+                         << endl;
+                }
+                _pipeline->Done(top, _save);
+                _framesDone += 1;
+            }
+        }
+        catch (std::exception &ex) {
+            _error = ex.what();
+        }
+    }
+
+    int getFramesDone() { return _framesDone; }
+    const string &getError() { return _error; }
+
+private:
+
+    SqlApplication *_app;
+    FramePipeline *_pipeline;
+    bool _save;
+    int _framesDone;
+    string _error;
+};
+
+
 SqlApplication::SqlApplication() {
     Calculatorfactory::RegisterAll();
 }
@@ -47,6 +218,15 @@ void SqlApplication::Initialize(void) {
         "  number of threads to create");
     AddProgramOptions() ("save,s", propt::value<int>()->default_value(1),
         "  whether or not to save changes to state file");
+    AddProgramOptions() ("snapshot", propt::value<int>()->default_value(0),
+        "  load frames from (and update) binary snapshots *.ctpbin");
+    AddProgramOptions() ("wal", propt::value<int>()->default_value(-1),
+        "  1: WAL journal, concurrent readers (local file systems only), "
+        "0: rollback journal, -1: keep");
+    AddProgramOptions() ("prefetch", propt::value<int>()->default_value(0),
+        "  read next and save previous frame while evaluating the current one");
+    AddProgramOptions() ("frame-threads", propt::value<int>()->default_value(1),
+        "  number of frames to evaluate concurrently (implies prefetch)");
 }
 
 
@@ -71,22 +251,84 @@ void SqlApplication::Run() {
     // STATESAVER & PROGRESS OBSERVER
     string statefile = OptionsMap()["file"].as<string>();
     StateSaverSQLite statsav;
+    statsav.setWAL(OptionsMap()["wal"].as<int>());
     statsav.Open(_top, statefile);
+    statsav.setSnapshots(OptionsMap()["snapshot"].as<int>() == 1);
     
     // INITIALIZE & RUN CALCULATORS
     cout << "Initializing calculators " << endl;
     BeginEvaluate(nThreads);
+    
+    // LOAD ONLY WHAT THE CALCULATORS USE
+    int parts = 0;
+    list< QMCalculator* > ::iterator it;
+    for (it = _calculators.begin(); it != _calculators.end(); it++) {
+        parts |= (*it)->TopologyParts();
+    }
+    statsav.setParts(parts);
+
+    // FUSE CHAINED PAIR-LOCAL CALCULATORS INTO ONE PASS OVER THE PAIRS
+    ParallelPairCalculator *pass = NULL;
+    for (it = _calculators.begin(); it != _calculators.end(); it++) {
+        ParallelPairCalculator *ppc = dynamic_cast<ParallelPairCalculator*>(*it);
+        if (ppc == NULL || !ppc->PairLocal()) { pass = NULL; continue; }
+        if (pass == NULL) { pass = ppc; continue; }
+        pass->AddStage(ppc);
+        cout << "Evaluating " << ppc->Identify() << " in the pass of " 
+             << pass->Identify() << endl;
+    }
+
+    // FRAMES IN PARALLEL ONLY IF ALL CALCULATORS ARE FRAME-INDEPENDENT
+    int frameThreads = OptionsMap()["frame-threads"].as<int>();
+    for (it = _calculators.begin(); it != _calculators.end(); it++) {
+        if (frameThreads > 1 && !(*it)->FrameIndependent()) {
+            cout << "Calculator " << (*it)->Identify() << " is not frame-"
+                 << "independent: evaluating one frame at a time." << endl;
+            frameThreads = 1;
+        }
+    }
+    if (frameThreads > nframes) frameThreads = nframes;
 
     int frameId = -1;
     int framesDone = 0;
-    while (statsav.NextFrame() && framesDone < nframes) {
-        frameId += 1;
-        if (frameId < fframe) continue;
-        cout << "Evaluating frame " << _top.getDatabaseId() << endl;
-        EvaluateFrame();
-        if (save == 1) { statsav.WriteFrame(); }
-        else { cout << "Changes have not been written to state file." << endl; }
-        framesDone += 1;
+    if ((OptionsMap()["prefetch"].as<int>() == 1 || frameThreads > 1) 
+        && nframes > 1) {
+        // Topologies in turn: being read, evaluated (one per thread), saved
+        vector<Topology*> tops;
+        tops.push_back(&_top);
+        for (int i = 0; i < frameThreads + 1; ++i) {
+            tops.push_back(new Topology());
+        }
+        
+        FramePipeline pipeline(statsav, tops, fframe, fframe + nframes);
+        pipeline.Start();
+        vector<FrameWorker*> workers;
+        for (int i = 0; i < frameThreads; ++i) {
+            workers.push_back(new FrameWorker(this, &pipeline, save == 1));
+            workers.back()->Start();
+        }
+        string error = "";
+        for (int i = 0; i < frameThreads; ++i) {
+            workers[i]->WaitDone();
+            framesDone += workers[i]->getFramesDone();
+            if (workers[i]->getError() != "") error = workers[i]->getError();
+            delete workers[i];
+        }
+        pipeline.Finish();
+        statsav.setTopology(_top);
+        for (unsigned int i = 1; i < tops.size(); ++i) delete tops[i];
+        if (error != "") throw runtime_error(error);
+    }
+    else {
+        while (statsav.NextFrame() && framesDone < nframes) {
+            frameId += 1;
+            if (frameId < fframe) continue;
+            cout << "Evaluating frame " << _top.getDatabaseId() << endl;
+            EvaluateFrame();
+            if (save == 1) { statsav.WriteFrame(); }
+            else { cout << "Changes have not been written to state file." << endl; }
+            framesDone += 1;
+        }
     }
     
     if (framesDone == 0)
@@ -117,10 +359,14 @@ void SqlApplication::BeginEvaluate(int nThreads = 1) {
 }
 
 bool SqlApplication::EvaluateFrame() {
+    return this->EvaluateFrame(&_top);
+}
+
+bool SqlApplication::EvaluateFrame(Topology *top) {
     list< QMCalculator* > ::iterator it;
     for (it = _calculators.begin(); it != _calculators.end(); it++) {
         cout << "... " << (*it)->Identify() << " " << flush;
-        (*it)->EvaluateFrame(&_top);
+        (*it)->EvaluateFrame(top);
         cout << endl;
     }
     return true;
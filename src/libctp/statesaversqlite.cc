@@ -19,14 +19,30 @@
 
 
 #include <votca/ctp/statesaversqlite.h>
+#include <votca/ctp/topologysnapshot.h>
 #include <votca/tools/statement.h>
+#include <boost/algorithm/string/join.hpp>
+#include <boost/format.hpp>
+#include <sys/stat.h>
+#include <fstream>
 
 namespace votca { namespace ctp {
 
 void StateSaverSQLite::Open(Topology& qmtop, const string &file, bool lock) {
     _sqlfile = file;
-    if (lock) this->LockStateFile();
+    if (lock) this->LockStateFile(false);
     _db.OpenHelper(file.c_str());
+
+    // WAL: readers see the last commit and do not block the writer (nor
+    // vice versa). Needs shared memory among the processes, i.e. not for
+    // state files on network file systems.
+    _db.Exec("PRAGMA busy_timeout = 60000;");
+    if (_wal == 1) _db.Exec("PRAGMA journal_mode = WAL;");
+    else if (_wal == 0) _db.Exec("PRAGMA journal_mode = DELETE;");
+    Statement *mode = _db.Prepare("PRAGMA journal_mode;");
+    _walActive = (mode->Step() == SQLITE_ROW 
+        && mode->Column<string>(0) == "wal");
+    delete mode;
     
     _qmtop = &qmtop;
     _frames.clear();
@@ -50,7 +66,9 @@ void StateSaverSQLite::Open(Topology& qmtop, const string &file, bool lock) {
 
 
 void StateSaverSQLite::WriteFrame() {
-    this->LockStateFile();
+    // Exclusive, but only for the write transaction: readers of the state
+    // file merely hold a shared lock while loading a frame
+    this->LockStateFile(true);
     bool hasAlready = this->HasTopology(_qmtop);
 
     if ( ! hasAlready ) {
@@ -73,17 +91,31 @@ void StateSaverSQLite::WriteFrame() {
 
     _db.BeginTransaction();    
 
+    // Parts not loaded are left as they are in the state file
+    int parts = (hasAlready) ? _parts : TOP_ALL;
     this->WriteMeta(hasAlready);
-    this->WriteMolecules(hasAlready);
-    this->WriteSegTypes(hasAlready);
-    this->WriteSegments(hasAlready);
-    this->WriteFragments(hasAlready);
-    this->WriteAtoms(hasAlready);
-    this->WritePairs(hasAlready);
-    this->WriteSuperExchange(hasAlready);
+    if (parts & TOP_MOLECULES)     this->WriteMolecules(hasAlready);
+    if (parts & TOP_SEGTYPES)      this->WriteSegTypes(hasAlready);
+    if (parts & TOP_SEGMENTS)      this->WriteSegments(hasAlready);
+    if (parts & TOP_FRAGMENTS)     this->WriteFragments(hasAlready);
+    if (parts & TOP_ATOMS)         this->WriteAtoms(hasAlready);
+    if (parts & TOP_PAIRS)         this->WritePairs(hasAlready);
+    if (parts & TOP_SUPEREXCHANGE) this->WriteSuperExchange(hasAlready);
+    
+    // Part of the transaction: committed (or not) along with the frame
+    _db.Exec((boost::format("PRAGMA user_version = %1$d;") 
+        % (this->StateGeneration()+1)).str());
 
     _db.EndTransaction();
 
+    // Snapshot of a partially loaded frame would be incomplete: left to go
+    // stale with the state file
+    if (_snapshots && parts == TOP_ALL) {
+        TopologySnapshot::Write(*_qmtop,
+            this->SnapshotFile(_qmtop->getDatabaseId()), this->StateStamp());
+        cout << ", snapshot" << flush;
+    }
+
     cout << ". " << endl;
     this->UnlockStateFile();
     return;
@@ -245,13 +277,8 @@ void StateSaverSQLite::WriteSegments(bool update) {
                             "?,     ?,  ?)");
     }
     else {
-        stmt = _db.Prepare("UPDATE segments "
-                           "SET "
-                           "UnCnNe = ?, UnCnNh = ?, UcNcCe = ?,"
-                           "UcNcCh = ?, UcCnNe = ?, UcCnNh = ?,"
-                           "eAnion = ?, eNeutral = ?, eCation = ?, "
-                           "occPe = ?, occPh = ?, has_e = ?, has_h = ? "
-                           "WHERE top = ? AND id = ?");
+        this->UpdateSegments();
+        return;
     }
 
     vector < Segment* > ::iterator sit;
@@ -260,41 +287,15 @@ void StateSaverSQLite::WriteSegments(bool update) {
             sit++) {
         Segment *seg = *sit;
 
-        if (!update) {
-
-            stmt->Bind(1, _qmtop->getDatabaseId());
-            stmt->Bind(2, seg->getTopology()->getDatabaseId());
-            stmt->Bind(3, seg->getId());
-            stmt->Bind(4, seg->getName());
-            stmt->Bind(5, seg->getType()->getId());
-            stmt->Bind(6, seg->getMolecule()->getId());
-            stmt->Bind(7, seg->getPos().getX());
-            stmt->Bind(8, seg->getPos().getY());
-            stmt->Bind(9, seg->getPos().getZ());
-        }
-
-        else {
-
-            int has_e = (seg->hasState(-1)) ? 1 : 0;
-            int has_h = (seg->hasState(+1)) ? 1 : 0;
-            
-            stmt->Bind(1, seg->getU_nC_nN(-1));
-            stmt->Bind(2, seg->getU_nC_nN(+1));
-            stmt->Bind(3, seg->getU_cN_cC(-1));
-            stmt->Bind(4, seg->getU_cN_cC(+1));
-            stmt->Bind(5, seg->getU_cC_nN(-1));
-            stmt->Bind(6, seg->getU_cC_nN(+1));
-            stmt->Bind(7, seg->getEMpoles(-1));
-            stmt->Bind(8, seg->getEMpoles(0));
-            stmt->Bind(9, seg->getEMpoles(1));
-            stmt->Bind(10,seg->getOcc(-1));
-            stmt->Bind(11,seg->getOcc(+1));
-            stmt->Bind(12,has_e);
-            stmt->Bind(13,has_h);
-            
-            stmt->Bind(14, _qmtop->getDatabaseId());
-            stmt->Bind(15, seg->getId());
-        }
+        stmt->Bind(1, _qmtop->getDatabaseId());
+        stmt->Bind(2, seg->getTopology()->getDatabaseId());
+        stmt->Bind(3, seg->getId());
+        stmt->Bind(4, seg->getName());
+        stmt->Bind(5, seg->getType()->getId());
+        stmt->Bind(6, seg->getMolecule()->getId());
+        stmt->Bind(7, seg->getPos().getX());
+        stmt->Bind(8, seg->getPos().getY());
+        stmt->Bind(9, seg->getPos().getZ());
 
         stmt->InsertStep();
         stmt->Reset();
@@ -306,6 +307,75 @@ void StateSaverSQLite::WriteSegments(bool update) {
 }
 
 
+void StateSaverSQLite::UpdateSegments() {
+    // Only rows with dirty column groups, only those groups. Statements are
+    // prepared once per combination of groups.
+    map<int, Statement*> stmts;
+    int updated = 0;
+    
+    vector < Segment* > ::iterator sit;
+    for (sit = _qmtop->Segments().begin();
+            sit < _qmtop->Segments().end();
+            sit++) {
+        Segment *seg = *sit;
+        int dirty = seg->getDirty();
+        if (!dirty) continue;
+        
+        Statement *stmt = stmts[dirty];
+        if (stmt == NULL) {
+            vector<string> cols;
+            if (dirty & Segment::DIRTY_U) 
+                cols.push_back("UnCnNe = ?, UnCnNh = ?, UcNcCe = ?,"
+                               "UcNcCh = ?, UcCnNe = ?, UcCnNh = ?");
+            if (dirty & Segment::DIRTY_EMPOLES)
+                cols.push_back("eAnion = ?, eNeutral = ?, eCation = ?");
+            if (dirty & Segment::DIRTY_OCC)
+                cols.push_back("occPe = ?, occPh = ?");
+            if (dirty & Segment::DIRTY_STATES)
+                cols.push_back("has_e = ?, has_h = ?");
+            stmt = _db.Prepare("UPDATE segments SET " 
+                + boost::algorithm::join(cols, ", ") 
+                + " WHERE top = ? AND id = ?");
+            stmts[dirty] = stmt;
+        }
+        
+        int col = 1;
+        if (dirty & Segment::DIRTY_U) {
+            stmt->Bind(col++, seg->getU_nC_nN(-1));
+            stmt->Bind(col++, seg->getU_nC_nN(+1));
+            stmt->Bind(col++, seg->getU_cN_cC(-1));
+            stmt->Bind(col++, seg->getU_cN_cC(+1));
+            stmt->Bind(col++, seg->getU_cC_nN(-1));
+            stmt->Bind(col++, seg->getU_cC_nN(+1));
+        }
+        if (dirty & Segment::DIRTY_EMPOLES) {
+            stmt->Bind(col++, seg->getEMpoles(-1));
+            stmt->Bind(col++, seg->getEMpoles(0));
+            stmt->Bind(col++, seg->getEMpoles(1));
+        }
+        if (dirty & Segment::DIRTY_OCC) {
+            stmt->Bind(col++, seg->getOcc(-1));
+            stmt->Bind(col++, seg->getOcc(+1));
+        }
+        if (dirty & Segment::DIRTY_STATES) {
+            stmt->Bind(col++, (seg->hasState(-1)) ? 1 : 0);
+            stmt->Bind(col++, (seg->hasState(+1)) ? 1 : 0);
+        }
+        stmt->Bind(col++, _qmtop->getDatabaseId());
+        stmt->Bind(col++, seg->getId());
+        
+        stmt->InsertStep();
+        stmt->Reset();
+        seg->setClean();
+        ++updated;
+    }
+    
+    map<int, Statement*>::iterator mit;
+    for (mit = stmts.begin(); mit != stmts.end(); ++mit) delete mit->second;
+    cout << " (" << updated << ")" << flush;
+}
+
+
 void StateSaverSQLite::WriteFragments(bool update) {
     cout << ", fragments" << flush;
 
@@ -461,14 +531,8 @@ void StateSaverSQLite::WritePairs(bool update) {
                            ")");
     }
     else {
-        stmt = _db.Prepare("UPDATE pairs "
-                           "SET "
-                           "has_e = ?, has_h = ?, "
-                           "lOe = ?, lOh = ?, rate12e = ?, "
-                           "rate21e = ?, rate12h = ?, rate21h = ?, "
-                           "Jeff2e = ?,  Jeff2h = ?, "
-                           "type = ? "
-                           "WHERE top = ? AND id = ?");
+        this->UpdatePairs();
+        return;
     }
 
     QMNBList::iterator nit;
@@ -479,62 +543,108 @@ void StateSaverSQLite::WritePairs(bool update) {
 
         QMPair *pair = *nit;
 
-        if (!update) {
-
-            int has_e = (pair->isPathCarrier(-1)) ? 1 : 0;
-            int has_h = (pair->isPathCarrier(+1)) ? 1 : 0;
+        int has_e = (pair->isPathCarrier(-1)) ? 1 : 0;
+        int has_h = (pair->isPathCarrier(+1)) ? 1 : 0;
 
-            stmt->Bind(1, _qmtop->getDatabaseId());
-            stmt->Bind(2, pair->getTopology()->getDatabaseId());
-            stmt->Bind(3, pair->getId());
-            stmt->Bind(4, pair->Seg1PbCopy()->getId());
-            stmt->Bind(5, pair->Seg2PbCopy()->getId());
-            stmt->Bind(6, pair->R().getX());
-            stmt->Bind(7, pair->R().getY());
-            stmt->Bind(8, pair->R().getZ());
-            stmt->Bind(9, has_e);
-            stmt->Bind(10, has_h);
-            stmt->Bind(11, pair->getLambdaO(-1));
-            stmt->Bind(12, pair->getLambdaO(+1));
-            stmt->Bind(13, pair->getRate12(-1));
-            stmt->Bind(14, pair->getRate21(-1));
-            stmt->Bind(15, pair->getRate12(+1));
-            stmt->Bind(16, pair->getRate21(+1));
-            stmt->Bind(17, pair->getJeff2(-1));
-            stmt->Bind(18, pair->getJeff2(+1));
-            stmt->Bind(19, (int)(pair->getType()) );
-        }
-        
-        else {
-
-            // cout << "\r " << pair->getId() << flush;
-
-                int has_e = (pair->isPathCarrier(-1)) ? 1 : 0;
-                int has_h = (pair->isPathCarrier(+1)) ? 1 : 0;
-
-                stmt->Bind(1, has_e);
-                stmt->Bind(2, has_h);
-                stmt->Bind(3, pair->getLambdaO(-1));
-                stmt->Bind(4, pair->getLambdaO(+1));
-                stmt->Bind(5, pair->getRate12(-1));
-                stmt->Bind(6, pair->getRate21(-1));
-                stmt->Bind(7, pair->getRate12(+1));
-                stmt->Bind(8, pair->getRate21(+1));
-                stmt->Bind(9, pair->getJeff2(-1));
-                stmt->Bind(10, pair->getJeff2(+1));
-                stmt->Bind(11, (int)pair->getType());
-                stmt->Bind(12, pair->getTopology()->getDatabaseId());
-                stmt->Bind(13, pair->getId());          
-        }
+        stmt->Bind(1, _qmtop->getDatabaseId());
+        stmt->Bind(2, pair->getTopology()->getDatabaseId());
+        stmt->Bind(3, pair->getId());
+        stmt->Bind(4, pair->Seg1PbCopy()->getId());
+        stmt->Bind(5, pair->Seg2PbCopy()->getId());
+        stmt->Bind(6, pair->R().getX());
+        stmt->Bind(7, pair->R().getY());
+        stmt->Bind(8, pair->R().getZ());
+        stmt->Bind(9, has_e);
+        stmt->Bind(10, has_h);
+        stmt->Bind(11, pair->getLambdaO(-1));
+        stmt->Bind(12, pair->getLambdaO(+1));
+        stmt->Bind(13, pair->getRate12(-1));
+        stmt->Bind(14, pair->getRate21(-1));
+        stmt->Bind(15, pair->getRate12(+1));
+        stmt->Bind(16, pair->getRate21(+1));
+        stmt->Bind(17, pair->getJeff2(-1));
+        stmt->Bind(18, pair->getJeff2(+1));
+        stmt->Bind(19, (int)(pair->getType()) );
 
         stmt->InsertStep();
         stmt->Reset();
+        pair->setClean();
     }
 
     delete stmt;
     stmt = NULL;
 }
 
+
+void StateSaverSQLite::UpdatePairs() {
+    // As ::UpdateSegments: dirty rows only, dirty column groups only
+    map<int, Statement*> stmts;
+    int updated = 0;
+    
+    QMNBList::iterator nit;
+    for (nit = _qmtop->NBList().begin();
+         nit != _qmtop->NBList().end();
+         nit++) {
+        QMPair *pair = *nit;
+        int dirty = pair->getDirty();
+        if (!dirty) continue;
+        
+        Statement *stmt = stmts[dirty];
+        if (stmt == NULL) {
+            vector<string> cols;
+            if (dirty & QMPair::DIRTY_CARRIERS)
+                cols.push_back("has_e = ?, has_h = ?");
+            if (dirty & QMPair::DIRTY_LAMBDA)
+                cols.push_back("lOe = ?, lOh = ?");
+            if (dirty & QMPair::DIRTY_RATES)
+                cols.push_back("rate12e = ?, rate21e = ?, "
+                               "rate12h = ?, rate21h = ?");
+            if (dirty & QMPair::DIRTY_JEFF2)
+                cols.push_back("Jeff2e = ?,  Jeff2h = ?");
+            if (dirty & QMPair::DIRTY_TYPE)
+                cols.push_back("type = ?");
+            stmt = _db.Prepare("UPDATE pairs SET " 
+                + boost::algorithm::join(cols, ", ")
+                + " WHERE top = ? AND id = ?");
+            stmts[dirty] = stmt;
+        }
+        
+        int col = 1;
+        if (dirty & QMPair::DIRTY_CARRIERS) {
+            stmt->Bind(col++, (pair->isPathCarrier(-1)) ? 1 : 0);
+            stmt->Bind(col++, (pair->isPathCarrier(+1)) ? 1 : 0);
+        }
+        if (dirty & QMPair::DIRTY_LAMBDA) {
+            stmt->Bind(col++, pair->getLambdaO(-1));
+            stmt->Bind(col++, pair->getLambdaO(+1));
+        }
+        if (dirty & QMPair::DIRTY_RATES) {
+            stmt->Bind(col++, pair->getRate12(-1));
+            stmt->Bind(col++, pair->getRate21(-1));
+            stmt->Bind(col++, pair->getRate12(+1));
+            stmt->Bind(col++, pair->getRate21(+1));
+        }
+        if (dirty & QMPair::DIRTY_JEFF2) {
+            stmt->Bind(col++, pair->getJeff2(-1));
+            stmt->Bind(col++, pair->getJeff2(+1));
+        }
+        if (dirty & QMPair::DIRTY_TYPE) {
+            stmt->Bind(col++, (int)pair->getType());
+        }
+        stmt->Bind(col++, pair->getTopology()->getDatabaseId());
+        stmt->Bind(col++, pair->getId());
+        
+        stmt->InsertStep();
+        stmt->Reset();
+        pair->setClean();
+        ++updated;
+    }
+    
+    map<int, Statement*>::iterator mit;
+    for (mit = stmts.begin(); mit != stmts.end(); ++mit) delete mit->second;
+    cout << " (" << updated << ")" << flush;
+}
+
 void StateSaverSQLite::WriteSuperExchange(bool update) {
     if ( ! _qmtop->NBList().getSuperExchangeTypes().size() ) { return; }
     
@@ -591,12 +701,15 @@ void StateSaverSQLite::WriteSuperExchange(bool update) {
 
 
 bool StateSaverSQLite::NextFrame() {
-    this->LockStateFile();
+    this->LockStateFile(false);
     bool hasNextFrame = false;
     _current_frame++;
 
     if(_current_frame < (int)_frames.size()) {
+        // One read transaction: a consistent view of the frame
+        _db.BeginTransaction();
         this->ReadFrame();
+        _db.EndTransaction();
         _was_read=true;
         hasNextFrame = true;
     }
@@ -614,23 +727,113 @@ void StateSaverSQLite::ReadFrame() {
          << " from " << _sqlfile << endl;
     cout << "...";
 
-    _qmtop->CleanUp();    
-    _qmtop->setDatabaseId(topId);
+    // Same composition as the frame loaded before => keep the objects and
+    // overwrite their properties. Not if calculators attached polar sites.
+    _reuse = !_snapshots && _qmtop->Segments().size() > 0
+        && _qmtop->PolarSites().empty() && _qmtop->APolarSites().empty();
+    bool inPlace = false;
+    if (_reuse) {
+        _qmtop->ResetFrame();
+        _qmtop->setDatabaseId(topId);
+        try {
+            this->ReadParts(topId);
+            cout << " (in place)" << flush;
+            inPlace = true;
+        }
+        catch (CompositionChanged &) {
+            cout << " (composition changed)" << flush;
+        }
+        _reuse = false;
+    }
     
+    if (!inPlace) {
+        _qmtop->CleanUp();    
+        _qmtop->setDatabaseId(topId);
+
+        string snapfile = this->SnapshotFile(topId);
+        if (_snapshots && TopologySnapshot::Read(*_qmtop, snapfile, 
+            this->StateStamp())) {
+            // Snapshot holds all parts, these are simply all loaded
+            cout << " Snapshot " << snapfile << flush;
+        }
+        else {
+            this->ReadParts(topId);
+
+            if (_snapshots && _parts == TOP_ALL) {
+                TopologySnapshot::Write(*_qmtop, snapfile, this->StateStamp());
+                cout << ", snapshot" << flush;
+            }
+        }
+    }
     
-    this->ReadMeta(topId);
-    this->ReadMolecules(topId);
-    this->ReadSegTypes(topId);
-    this->ReadSegments(topId);
-    this->ReadFragments(topId);
-    this->ReadAtoms(topId);    
-    this->ReadPairs(topId);
-    this->ReadSuperExchange(topId);
+    // Loaded rows match the state file, nothing to write back so far
+    vector<Segment*>::iterator sit;
+    for (sit = _qmtop->Segments().begin(); sit < _qmtop->Segments().end(); ++sit)
+        (*sit)->setClean();
+    QMNBList::iterator nit;
+    for (nit = _qmtop->NBList().begin(); nit != _qmtop->NBList().end(); ++nit)
+        (*nit)->setClean();
     
     cout << ". " << endl;
 }
 
 
+void StateSaverSQLite::ReadParts(int topId) {
+    this->ReadMeta(topId);
+    if (_parts & TOP_MOLECULES)     this->ReadMolecules(topId);
+    if (_parts & TOP_SEGTYPES)      this->ReadSegTypes(topId);
+    if (_parts & TOP_SEGMENTS)      this->ReadSegments(topId);
+    if (_parts & TOP_FRAGMENTS)     this->ReadFragments(topId);
+    if (_parts & TOP_ATOMS)         this->ReadAtoms(topId);    
+    if (_parts & TOP_PAIRS)         this->ReadPairs(topId);
+    if (_parts & TOP_SUPEREXCHANGE) this->ReadSuperExchange(topId);
+}
+
+
+void StateSaverSQLite::setParts(int parts) {
+    // Add what the requested parts refer to: atoms => fragments, segments, 
+    // molecules; fragments, pairs => segments; segments => molecules, types
+    if (parts & TOP_ATOMS)     parts |= TOP_FRAGMENTS;
+    if (parts & TOP_FRAGMENTS) parts |= TOP_SEGMENTS;
+    if (parts & TOP_PAIRS)     parts |= TOP_SEGMENTS;
+    if (parts & TOP_SEGMENTS)  parts |= TOP_MOLECULES | TOP_SEGTYPES;
+    _parts = parts;
+}
+
+
+string StateSaverSQLite::SnapshotFile(int topId) {
+    return (boost::format("%1$s.frame%2$d.ctpbin") % _sqlfile % topId).str();
+}
+
+
+int StateSaverSQLite::StateGeneration() {
+    Statement *stmt = _db.Prepare("PRAGMA user_version;");
+    int generation = (stmt->Step() == SQLITE_ROW) ? stmt->Column<int>(0) : 0;
+    delete stmt;
+    return generation;
+}
+
+
+string StateSaverSQLite::StateStamp() {
+    // Generation: bumped by each ::WriteFrame. Under WAL commits go to the
+    // -wal file and leave the state file as it is, so other writers (kmc,
+    // ...) are caught by size and modification time of both files.
+    struct stat st;
+    if (stat(_sqlfile.c_str(), &st) != 0) {
+        throw runtime_error("Cannot stat state file " + _sqlfile);
+    }
+    string stamp = (boost::format("%1$d %2$d:%3$d.%4$09d") 
+        % this->StateGeneration() % st.st_size 
+        % st.st_mtim.tv_sec % st.st_mtim.tv_nsec).str();
+    string walfile = _sqlfile + "-wal";
+    if (stat(walfile.c_str(), &st) == 0) {
+        stamp += (boost::format(" %1$d:%2$d.%3$09d") % st.st_size 
+            % st.st_mtim.tv_sec % st.st_mtim.tv_nsec).str();
+    }
+    return stamp;
+}
+
+
 void StateSaverSQLite::ReadMeta(int topId) {
 
     Statement *stmt = _db.Prepare("SELECT "
@@ -671,11 +874,22 @@ void StateSaverSQLite::ReadMolecules(int topId) {
                                   "FROM molecules "
                                   "WHERE top = ?;");
     stmt->Bind(1, topId);
+    unsigned int row = 0;
     while (stmt->Step() != SQLITE_DONE) {
+        if (_reuse) {
+            if (row >= _qmtop->Molecules().size() || _qmtop->Molecules()[row]
+                ->getName() != stmt->Column<string>(0)) {
+                delete stmt;
+                throw CompositionChanged();
+            }
+            ++row;
+            continue;
+        }
         //Molecule *mol = 
 	(void) _qmtop->AddMolecule(stmt->Column<string>(0));
     }
     delete stmt;
+    if (_reuse && row != _qmtop->Molecules().size()) throw CompositionChanged();
     stmt = NULL;
 }
 
@@ -691,8 +905,21 @@ void StateSaverSQLite::ReadSegTypes(int topId) {
                                   "WHERE top = ?;");
 
     stmt->Bind(1, topId);
+    unsigned int row = 0;
     while (stmt->Step() != SQLITE_DONE) {
-        SegmentType *type = _qmtop->AddSegmentType(stmt->Column<string>(0));
+        SegmentType *type = NULL;
+        if (_reuse) {
+            if (row >= _qmtop->SegmentTypes().size() 
+                || _qmtop->SegmentTypes()[row]->getName() 
+                != stmt->Column<string>(0)) {
+                delete stmt;
+                throw CompositionChanged();
+            }
+            type = _qmtop->SegmentTypes()[row++];
+        }
+        else {
+            type = _qmtop->AddSegmentType(stmt->Column<string>(0));
+        }
         type->setBasisName(stmt->Column<string>(1));
         type->setOrbitalsFile(stmt->Column<string>(2));
         type->setQMCoordsFile(stmt->Column<string>(4));
@@ -717,6 +944,9 @@ void StateSaverSQLite::ReadSegTypes(int topId) {
 
     delete stmt;
     stmt = NULL;
+    if (_reuse && row != _qmtop->SegmentTypes().size()) {
+        throw CompositionChanged();
+    }
 }
 
 
@@ -734,6 +964,8 @@ void StateSaverSQLite::ReadSegments(int topId) {
                                   "FROM segments "
                                   "WHERE top = ?;");
     stmt->Bind(1, topId);
+    unsigned int row = 0;
+    bool changed = false;
 
     while (stmt->Step() != SQLITE_DONE) {
 
@@ -760,9 +992,20 @@ void StateSaverSQLite::ReadSegments(int topId) {
         bool has_e = (he == 1) ? true : false;
         bool has_h = (hh == 1) ? true : false;
 
-        Segment *seg = _qmtop->AddSegment(name);
-        seg->setMolecule(_qmtop->getMolecule(mId));
-        seg->setType(_qmtop->getSegmentType(type));
+        Segment *seg = NULL;
+        if (_reuse) {
+            if (row >= _qmtop->Segments().size()) { changed = true; break; }
+            seg = _qmtop->Segments()[row++];
+            if (seg->getName() != name || seg->getMolecule()->getId() != mId
+                || seg->getType()->getId() != type) { changed = true; break; }
+            seg->ResetState();
+        }
+        else {
+            seg = _qmtop->AddSegment(name);
+            seg->setMolecule(_qmtop->getMolecule(mId));
+            seg->setType(_qmtop->getSegmentType(type));
+            seg->getMolecule()->AddSegment(seg);
+        }
         seg->setPos(vec(X, Y, Z));
         seg->setU_nC_nN(l1, -1);
         seg->setU_nC_nN(l2, +1);
@@ -777,12 +1020,12 @@ void StateSaverSQLite::ReadSegments(int topId) {
         seg->setOcc(o2, +1);
         seg->setHasState(has_e, -1);
         seg->setHasState(has_h, +1);
-        
-
-        seg->getMolecule()->AddSegment(seg);
     }
     delete stmt;
     stmt = NULL;
+    if (_reuse && (changed || row != _qmtop->Segments().size())) {
+        throw CompositionChanged();
+    }
 }
 
 
@@ -798,6 +1041,8 @@ void StateSaverSQLite::ReadFragments(int topId) {
                                   "WHERE top = ?;");
 
     stmt->Bind(1, topId);
+    unsigned int row = 0;
+    bool changed = false;
 
     while (stmt->Step() != SQLITE_DONE) {
 
@@ -817,19 +1062,31 @@ void StateSaverSQLite::ReadFragments(int topId) {
         if (leg2 >= 0) {trihedron.push_back(leg2);}
         if (leg3 >= 0) {trihedron.push_back(leg3);}
 
-        Fragment *frag = _qmtop->AddFragment(name);
-        frag->setSegment(_qmtop->getSegment(segid));
-        frag->setMolecule(_qmtop->getMolecule(molid));
+        Fragment *frag = NULL;
+        if (_reuse) {
+            if (row >= _qmtop->Fragments().size()) { changed = true; break; }
+            frag = _qmtop->Fragments()[row++];
+            if (frag->getName() != name || frag->getSegment()->getId() != segid
+                || frag->getMolecule()->getId() != molid) { 
+                changed = true; break; 
+            }
+        }
+        else {
+            frag = _qmtop->AddFragment(name);
+            frag->setSegment(_qmtop->getSegment(segid));
+            frag->setMolecule(_qmtop->getMolecule(molid));
+            frag->getSegment()->AddFragment(frag);
+            frag->getMolecule()->AddFragment(frag);
+        }
         frag->setPos(vec(posX, posY, posZ));
         frag->setSymmetry(symm);
         frag->setTrihedron(trihedron);
-
-        frag->getSegment()->AddFragment(frag);
-        frag->getMolecule()->AddFragment(frag);
-
     }
     delete stmt;
     stmt = NULL;
+    if (_reuse && (changed || row != _qmtop->Fragments().size())) {
+        throw CompositionChanged();
+    }
 }
 
 
@@ -847,6 +1104,8 @@ void StateSaverSQLite::ReadAtoms(int topId) {
                                   "WHERE top = ?;");
 
     stmt->Bind(1, topId);
+    unsigned int row = 0;
+    bool changed = false;
 
     while (stmt->Step() != SQLITE_DONE) {
 
@@ -866,25 +1125,39 @@ void StateSaverSQLite::ReadAtoms(int topId) {
         double  qmPosZ = stmt->Column<double>(13);
         string  element = stmt->Column<string>(14);
 
-        Atom *atm = _qmtop->AddAtom(name);
+        Atom *atm = NULL;
+        if (_reuse) {
+            if (row >= _qmtop->Atoms().size()) { changed = true; break; }
+            atm = _qmtop->Atoms()[row++];
+            if (atm->getName() != name || atm->getFragment()->getId() != fragid
+                || atm->getSegment()->getId() != segid
+                || atm->getMolecule()->getId() != molid) { 
+                changed = true; break; 
+            }
+        }
+        else {
+            atm = _qmtop->AddAtom(name);
+            atm->setFragment(_qmtop->getFragment(fragid));
+            atm->setSegment(_qmtop->getSegment(segid));
+            atm->setMolecule(_qmtop->getMolecule(molid));
+
+            atm->getFragment()->AddAtom(atm);
+            atm->getSegment()->AddAtom(atm);
+            atm->getMolecule()->AddAtom(atm);
+        }
         atm->setWeight(weight);
         atm->setQMPart(qmid, vec(qmPosX,qmPosY,qmPosZ));
         atm->setElement(element);
         atm->setPos( vec(posX, posY, posZ) );
-        
-        atm->setFragment(_qmtop->getFragment(fragid));
-        atm->setSegment(_qmtop->getSegment(segid));
-        atm->setMolecule(_qmtop->getMolecule(molid));
-
-        atm->getFragment()->AddAtom(atm);
-        atm->getSegment()->AddAtom(atm);
-        atm->getMolecule()->AddAtom(atm);
 
         atm->setResnr(resnr);
         atm->setResname(resname);  
     }
     delete stmt;
     stmt = NULL;
+    if (_reuse && (changed || row != _qmtop->Atoms().size())) {
+        throw CompositionChanged();
+    }
 }
 
 
@@ -987,16 +1260,27 @@ int StateSaverSQLite::FramesInDatabase() {
 }
 
 
-void StateSaverSQLite::LockStateFile() {    
-    _flock = new boost::interprocess::file_lock(_sqlfile.c_str());
-    _flock->lock();
+void StateSaverSQLite::LockStateFile(bool exclusive) {
+    // Not the state file itself: releasing a lock on it closes a descriptor,
+    // which drops the fcntl locks SQLite holds on the same file
+    if (_walActive) return;
+    string lockfile = _sqlfile + ".lock";
+    std::ofstream touch(lockfile.c_str(), std::ofstream::app);
+    touch.close();
+    _flock = new boost::interprocess::file_lock(lockfile.c_str());
+    if (exclusive) _flock->lock();
+    else _flock->lock_sharable();
+    _flockShared = !exclusive;
     return;
 }
 
 
 void StateSaverSQLite::UnlockStateFile() {
-    _flock->unlock();
+    if (_flock == NULL) return;
+    if (_flockShared) _flock->unlock_sharable();
+    else _flock->unlock();
     delete _flock;
+    _flock = NULL;
     return;
 }
 
@@ -26,7 +26,8 @@ namespace votca { namespace ctp {
 
 Topology::Topology() : _db_id(-1), _hasPb(0), 
                        _bc(NULL), _nblist(this),
-                       _isRigid(false), _isEStatified(false)  { }
+                       _isRigid(false), _isEStatified(false),
+                       _arraysValid(false) { }
 
 // +++++++++++++++++++++ //
 // Clean-Up, Destruct    //
@@ -53,6 +54,14 @@ void Topology::CleanUp() {
     
     _nblist.Cleanup();
     _isRigid = false;
+    _arraysValid = false;
+}
+
+
+void Topology::ResetFrame() {
+    _nblist.Cleanup();
+    _isRigid = false;
+    _arraysValid = false;
 }
 
 
@@ -91,6 +100,7 @@ Fragment *Topology::AddFragment(string fragment_name) {
     int fragment_id = _fragments.size() + 1;
     Fragment* fragment = new Fragment(fragment_id, fragment_name);
     _fragments.push_back(fragment);
+    _arraysValid = false;
     fragment->setTopology(this);
     return fragment;
 }
@@ -99,6 +109,7 @@ Segment *Topology::AddSegment(string segment_name) {
     int segment_id = _segments.size() + 1;
     Segment* segment = new Segment(segment_id, segment_name);
     _segments.push_back(segment);
+    _arraysValid = false;
     segment->setTopology(this);
     return segment;
 }
@@ -280,6 +291,7 @@ bool Topology::Rigidify() {
         }
 
         _isRigid = true;
+        _arraysValid = false;
         return 1;
     }
 }
@@ -290,6 +302,43 @@ bool Topology::Rigidify() {
 
 
 
+const TopologyArrays &Topology::Arrays() {
+
+    _arraysMutex.Lock();
+    if (!_arraysValid) {
+        TopologyArrays &A = _arrays;
+        A.clear();
+        A.segFragBegin.push_back(0);
+
+        vector<Segment*>::iterator sit;
+        for (sit = _segments.begin(); sit < _segments.end(); ++sit) {
+            Segment *seg = *sit;
+            A.segX.push_back(seg->getPos().getX());
+            A.segY.push_back(seg->getPos().getY());
+            A.segZ.push_back(seg->getPos().getZ());
+            A.segType.push_back((seg->getType()) ? seg->getType()->getId() : 0);
+            A.segName.push_back(seg->getNameId());
+            A.segments.push_back(seg);
+
+            vector<Fragment*>::iterator fit;
+            for (fit = seg->Fragments().begin(); fit < seg->Fragments().end();
+                ++fit) {
+                A.fragX.push_back((*fit)->getPos().getX());
+                A.fragY.push_back((*fit)->getPos().getY());
+                A.fragZ.push_back((*fit)->getPos().getZ());
+                A.fragSeg.push_back(A.segments.size()-1);
+                A.fragName.push_back((*fit)->getNameId());
+                A.fragments.push_back(*fit);
+            }
+            A.segFragBegin.push_back(A.fragments.size());
+        }
+        _arraysValid = true;
+    }
+    _arraysMutex.Unlock();
+    return _arrays;
+}
+
+
 void Topology::PrintInfo(ostream &out) {
         cout << endl;
 
@@ -0,0 +1,478 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+#include <votca/ctp/topologysnapshot.h>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/filesystem.hpp>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <stdint.h>
+
+namespace votca { namespace ctp {
+
+
+namespace {
+
+const char    SNAP_MAGIC[8] = {'C','T','P','B','I','N','\0','\0'};
+const int32_t SNAP_VERSION  = 1;
+
+enum SnapSection {
+    SEC_STRINGS, SEC_META, SEC_MOLECULES, SEC_SEGTYPES, SEC_SEGMENTS,
+    SEC_FRAGMENTS, SEC_ATOMS, SEC_PAIRS, SEC_SUPEREXCHANGE, SEC_COUNT
+};
+
+// Records: doubles first, int32 padded to a multiple of 8 bytes
+
+struct SnapHeader {
+    char    magic[8];
+    int32_t version;
+    int32_t endian;
+    int64_t offset[SEC_COUNT];
+    int64_t count[SEC_COUNT];
+};
+
+struct SnapMeta {
+    double  time;
+    double  box[9];
+    int32_t step;
+    int32_t canRigid;
+    int32_t stamp;
+    int32_t pad;
+};
+
+struct SnapSegType {
+    int32_t name, basis, orbfile, coordfile, canRigid, pad;
+};
+
+struct SnapSegment {
+    double  pos[3];
+    double  U[6];
+    double  empoles[3];
+    double  occ[2];
+    int32_t name, type, mol, has_e, has_h, pad;
+};
+
+struct SnapFragment {
+    double  pos[3];
+    int32_t name, mol, seg, symmetry, leg[3], pad;
+};
+
+struct SnapAtom {
+    double  pos[3];
+    double  qmPos[3];
+    double  weight;
+    int32_t name, mol, seg, frag, resnr, resname, qmid, element;
+};
+
+struct SnapPair {
+    double  lambdaO[2];
+    double  rates[4];
+    double  Jeff2[2];
+    int32_t seg1, seg2, has_e, has_h, type, pad;
+};
+
+
+class StringTable
+{
+public:
+    int32_t Intern(const string &str) {
+        std::map<string,int32_t>::iterator it = _ids.find(str);
+        if (it != _ids.end()) return it->second;
+        int32_t id = _strings.size();
+        _ids[str] = id;
+        _strings.push_back(str);
+        return id;
+    }
+    vector<string> &Strings() { return _strings; }
+private:
+    std::map<string,int32_t> _ids;
+    vector<string> _strings;
+};
+
+
+template<typename T>
+void WriteSection(std::ofstream &out, SnapHeader &header, int sec,
+    const vector<T> &records) {
+    header.offset[sec] = out.tellp();
+    header.count[sec] = records.size();
+    if (records.size()) {
+        out.write((const char*) &records[0], records.size()*sizeof(T));
+    }
+    while (out.tellp() % 8) out.put('\0');
+}
+
+
+template<typename T>
+const T *Section(const char *base, size_t size, const SnapHeader *header,
+    int sec) {
+    size_t end = header->offset[sec] + header->count[sec]*sizeof(T);
+    if (header->offset[sec] < (int64_t)sizeof(SnapHeader) || end > size) {
+        throw runtime_error("Snapshot appears to be broken. Abort...");
+    }
+    return (const T*) (base + header->offset[sec]);
+}
+
+}
+
+
+void TopologySnapshot::Write(Topology &top, const string &file,
+    const string &stamp) {
+
+    StringTable strings;
+
+    vector<SnapMeta> meta(1);
+    std::memset(&meta[0], 0, sizeof(SnapMeta));
+    meta[0].time = top.getTime();
+    meta[0].step = top.getStep();
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            meta[0].box[3*i+j] = top.getBox().get(i,j);
+        }
+    }
+    meta[0].canRigid = (top.canRigidify()) ? 1 : 0;
+    meta[0].stamp = strings.Intern(stamp);
+
+    vector<int32_t> mols;
+    vector<Molecule*>::iterator mit;
+    for (mit = top.Molecules().begin(); mit < top.Molecules().end(); ++mit) {
+        mols.push_back(strings.Intern((*mit)->getName()));
+    }
+
+    vector<SnapSegType> types;
+    vector<SegmentType*>::iterator tit;
+    for (tit = top.SegmentTypes().begin(); tit < top.SegmentTypes().end();
+        ++tit) {
+        SnapSegType rec = {
+            strings.Intern((*tit)->getName()),
+            strings.Intern((*tit)->getBasisName()),
+            strings.Intern((*tit)->getOrbitalsFile()),
+            strings.Intern((*tit)->getQMCoordsFile()),
+            ((*tit)->canRigidify()) ? 1 : 0, 0 };
+        types.push_back(rec);
+    }
+
+    vector<SnapSegment> segs;
+    vector<Segment*>::iterator sit;
+    for (sit = top.Segments().begin(); sit < top.Segments().end(); ++sit) {
+        Segment *seg = *sit;
+        SnapSegment rec;
+        std::memset(&rec, 0, sizeof(rec));
+        rec.pos[0] = seg->getPos().getX();
+        rec.pos[1] = seg->getPos().getY();
+        rec.pos[2] = seg->getPos().getZ();
+        rec.U[0] = seg->getU_nC_nN(-1);
+        rec.U[1] = seg->getU_nC_nN(+1);
+        rec.U[2] = seg->getU_cN_cC(-1);
+        rec.U[3] = seg->getU_cN_cC(+1);
+        rec.U[4] = seg->getU_cC_nN(-1);
+        rec.U[5] = seg->getU_cC_nN(+1);
+        rec.empoles[0] = seg->getEMpoles(-1);
+        rec.empoles[1] = seg->getEMpoles(0);
+        rec.empoles[2] = seg->getEMpoles(+1);
+        rec.occ[0] = seg->getOcc(-1);
+        rec.occ[1] = seg->getOcc(+1);
+        rec.name = strings.Intern(seg->getName());
+        rec.type = seg->getType()->getId();
+        rec.mol = seg->getMolecule()->getId();
+        rec.has_e = (seg->hasState(-1)) ? 1 : 0;
+        rec.has_h = (seg->hasState(+1)) ? 1 : 0;
+        segs.push_back(rec);
+    }
+
+    vector<SnapFragment> frags;
+    vector<Fragment*>::iterator fit;
+    for (fit = top.Fragments().begin(); fit < top.Fragments().end(); ++fit) {
+        Fragment *frag = *fit;
+        SnapFragment rec;
+        std::memset(&rec, 0, sizeof(rec));
+        rec.pos[0] = frag->getPos().getX();
+        rec.pos[1] = frag->getPos().getY();
+        rec.pos[2] = frag->getPos().getZ();
+        rec.name = strings.Intern(frag->getName());
+        rec.mol = frag->getMolecule()->getId();
+        rec.seg = frag->getSegment()->getId();
+        rec.symmetry = frag->getSymmetry();
+        for (int i = 0; i < 3; i++) {
+            rec.leg[i] = (i < (int)frag->getTrihedron().size()) ?
+                frag->getTrihedron()[i] : -1;
+        }
+        frags.push_back(rec);
+    }
+
+    vector<SnapAtom> atoms;
+    vector<Atom*>::iterator ait;
+    for (ait = top.Atoms().begin(); ait < top.Atoms().end(); ++ait) {
+        Atom *atm = *ait;
+        SnapAtom rec;
+        rec.pos[0] = atm->getPos().getX();
+        rec.pos[1] = atm->getPos().getY();
+        rec.pos[2] = atm->getPos().getZ();
+        rec.qmPos[0] = atm->getQMPos().getX();
+        rec.qmPos[1] = atm->getQMPos().getY();
+        rec.qmPos[2] = atm->getQMPos().getZ();
+        rec.weight = atm->getWeight();
+        rec.name = strings.Intern(atm->getName());
+        rec.mol = atm->getMolecule()->getId();
+        rec.seg = atm->getSegment()->getId();
+        rec.frag = atm->getFragment()->getId();
+        rec.resnr = atm->getResnr();
+        rec.resname = strings.Intern(atm->getResname());
+        rec.qmid = atm->getQMId();
+        rec.element = strings.Intern(atm->getElement());
+        atoms.push_back(rec);
+    }
+
+    vector<SnapPair> pairs;
+    QMNBList::iterator nit;
+    for (nit = top.NBList().begin(); nit != top.NBList().end(); ++nit) {
+        QMPair *pair = *nit;
+        SnapPair rec;
+        std::memset(&rec, 0, sizeof(rec));
+        rec.lambdaO[0] = pair->getLambdaO(-1);
+        rec.lambdaO[1] = pair->getLambdaO(+1);
+        rec.rates[0] = pair->getRate12(-1);
+        rec.rates[1] = pair->getRate21(-1);
+        rec.rates[2] = pair->getRate12(+1);
+        rec.rates[3] = pair->getRate21(+1);
+        rec.Jeff2[0] = pair->getJeff2(-1);
+        rec.Jeff2[1] = pair->getJeff2(+1);
+        rec.seg1 = pair->Seg1PbCopy()->getId();
+        rec.seg2 = pair->Seg2PbCopy()->getId();
+        rec.has_e = (pair->isPathCarrier(-1)) ? 1 : 0;
+        rec.has_h = (pair->isPathCarrier(+1)) ? 1 : 0;
+        rec.type = (int)pair->getType();
+        pairs.push_back(rec);
+    }
+
+    vector<int32_t> superx;
+    list<QMNBList::SuperExchangeType*>::const_iterator seit;
+    for (seit = top.NBList().getSuperExchangeTypes().begin();
+         seit != top.NBList().getSuperExchangeTypes().end(); ++seit) {
+        superx.push_back(strings.Intern((*seit)->asString()));
+    }
+
+    // String table: offsets [n+1], then the characters
+    vector<int64_t> stroffs(1, 0);
+    string strdata;
+    vector<string>::iterator strit;
+    for (strit = strings.Strings().begin(); strit < strings.Strings().end();
+        ++strit) {
+        strdata += *strit;
+        stroffs.push_back(strdata.size());
+    }
+
+    SnapHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SNAP_MAGIC, sizeof(header.magic));
+    header.version = SNAP_VERSION;
+    header.endian = 1;
+
+    string tmpfile = file + ".tmp";
+    std::ofstream out(tmpfile.c_str(), std::ios::out | std::ios::binary);
+    if (!out.is_open()) {
+        throw runtime_error("Bad file handle: " + tmpfile);
+    }
+    out.write((const char*) &header, sizeof(header));
+
+    WriteSection(out, header, SEC_STRINGS, stroffs);
+    header.count[SEC_STRINGS] = strings.Strings().size();
+    out.write(strdata.c_str(), strdata.size());
+    while (out.tellp() % 8) out.put('\0');
+    WriteSection(out, header, SEC_META, meta);
+    WriteSection(out, header, SEC_MOLECULES, mols);
+    WriteSection(out, header, SEC_SEGTYPES, types);
+    WriteSection(out, header, SEC_SEGMENTS, segs);
+    WriteSection(out, header, SEC_FRAGMENTS, frags);
+    WriteSection(out, header, SEC_ATOMS, atoms);
+    WriteSection(out, header, SEC_PAIRS, pairs);
+    WriteSection(out, header, SEC_SUPEREXCHANGE, superx);
+
+    out.seekp(0);
+    out.write((const char*) &header, sizeof(header));
+    out.close();
+    if (!out) throw runtime_error("Error writing snapshot " + tmpfile);
+
+    boost::filesystem::rename(tmpfile, file);
+}
+
+
+bool TopologySnapshot::Read(Topology &top, const string &file,
+    const string &stamp) {
+
+    if (!boost::filesystem::exists(file)) return false;
+
+    namespace bip = boost::interprocess;
+    bip::file_mapping mapping(file.c_str(), bip::read_only);
+    bip::mapped_region region(mapping, bip::read_only);
+    const char *base = (const char*) region.get_address();
+    size_t size = region.get_size();
+
+    // Foreign, outdated or stale snapshots are simply not used
+    if (size < sizeof(SnapHeader)) return false;
+    const SnapHeader *header = (const SnapHeader*) base;
+    if (std::memcmp(header->magic, SNAP_MAGIC, sizeof(SNAP_MAGIC))
+        || header->version != SNAP_VERSION || header->endian != 1) {
+        return false;
+    }
+
+    const int64_t *stroffs = Section<int64_t>(base, size, header, SEC_STRINGS);
+    int64_t nstrings = header->count[SEC_STRINGS];
+    const char *strdata = (const char*) (stroffs + nstrings + 1);
+    if (strdata + stroffs[nstrings] > base + size) {
+        throw runtime_error("Snapshot appears to be broken. Abort...");
+    }
+    vector<string> strings;
+    strings.reserve(nstrings);
+    for (int64_t i = 0; i < nstrings; ++i) {
+        strings.push_back(string(strdata + stroffs[i],
+            stroffs[i+1] - stroffs[i]));
+    }
+
+    const SnapMeta *meta = Section<SnapMeta>(base, size, header, SEC_META);
+    if (header->count[SEC_META] != 1 || meta->stamp >= nstrings
+        || strings[meta->stamp] != stamp) {
+        return false;
+    }
+
+    top.setTime(meta->time);
+    top.setStep(meta->step);
+    matrix boxv;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            boxv.set(i, j, meta->box[3*i+j]);
+        }
+    }
+    top.setBox(boxv);
+    top.setCanRigidify(meta->canRigid);
+
+    const int32_t *mols = Section<int32_t>(base, size, header, SEC_MOLECULES);
+    for (int64_t i = 0; i < header->count[SEC_MOLECULES]; ++i) {
+        top.AddMolecule(strings[mols[i]]);
+    }
+
+    const SnapSegType *types = Section<SnapSegType>(base, size, header,
+        SEC_SEGTYPES);
+    for (int64_t i = 0; i < header->count[SEC_SEGTYPES]; ++i) {
+        SegmentType *type = top.AddSegmentType(strings[types[i].name]);
+        type->setBasisName(strings[types[i].basis]);
+        type->setOrbitalsFile(strings[types[i].orbfile]);
+        type->setQMCoordsFile(strings[types[i].coordfile]);
+        type->setCanRigidify(types[i].canRigid);
+    }
+
+    const SnapSegment *segs = Section<SnapSegment>(base, size, header,
+        SEC_SEGMENTS);
+    top.Segments().reserve(header->count[SEC_SEGMENTS]);
+    for (int64_t i = 0; i < header->count[SEC_SEGMENTS]; ++i) {
+        const SnapSegment &rec = segs[i];
+        Segment *seg = top.AddSegment(strings[rec.name]);
+        seg->setMolecule(top.getMolecule(rec.mol));
+        seg->setType(top.getSegmentType(rec.type));
+        seg->setPos(vec(rec.pos[0], rec.pos[1], rec.pos[2]));
+        seg->setU_nC_nN(rec.U[0], -1);
+        seg->setU_nC_nN(rec.U[1], +1);
+        seg->setU_cN_cC(rec.U[2], -1);
+        seg->setU_cN_cC(rec.U[3], +1);
+        seg->setU_cC_nN(rec.U[4], -1);
+        seg->setU_cC_nN(rec.U[5], +1);
+        seg->setEMpoles(-1, rec.empoles[0]);
+        seg->setEMpoles(0, rec.empoles[1]);
+        seg->setEMpoles(1, rec.empoles[2]);
+        seg->setOcc(rec.occ[0], -1);
+        seg->setOcc(rec.occ[1], +1);
+        seg->setHasState(rec.has_e == 1, -1);
+        seg->setHasState(rec.has_h == 1, +1);
+        seg->getMolecule()->AddSegment(seg);
+    }
+
+    const SnapFragment *frags = Section<SnapFragment>(base, size, header,
+        SEC_FRAGMENTS);
+    top.Fragments().reserve(header->count[SEC_FRAGMENTS]);
+    for (int64_t i = 0; i < header->count[SEC_FRAGMENTS]; ++i) {
+        const SnapFragment &rec = frags[i];
+        vector<int> trihedron;
+        trihedron.push_back(rec.leg[0]);
+        if (rec.leg[1] >= 0) trihedron.push_back(rec.leg[1]);
+        if (rec.leg[2] >= 0) trihedron.push_back(rec.leg[2]);
+
+        Fragment *frag = top.AddFragment(strings[rec.name]);
+        frag->setSegment(top.getSegment(rec.seg));
+        frag->setMolecule(top.getMolecule(rec.mol));
+        frag->setPos(vec(rec.pos[0], rec.pos[1], rec.pos[2]));
+        frag->setSymmetry(rec.symmetry);
+        frag->setTrihedron(trihedron);
+        frag->getSegment()->AddFragment(frag);
+        frag->getMolecule()->AddFragment(frag);
+    }
+
+    const SnapAtom *atoms = Section<SnapAtom>(base, size, header, SEC_ATOMS);
+    top.Atoms().reserve(header->count[SEC_ATOMS]);
+    for (int64_t i = 0; i < header->count[SEC_ATOMS]; ++i) {
+        const SnapAtom &rec = atoms[i];
+        Atom *atm = top.AddAtom(strings[rec.name]);
+        atm->setWeight(rec.weight);
+        atm->setQMPart(rec.qmid, vec(rec.qmPos[0],rec.qmPos[1],rec.qmPos[2]));
+        atm->setElement(strings[rec.element]);
+        atm->setPos(vec(rec.pos[0], rec.pos[1], rec.pos[2]));
+
+        atm->setFragment(top.getFragment(rec.frag));
+        atm->setSegment(top.getSegment(rec.seg));
+        atm->setMolecule(top.getMolecule(rec.mol));
+
+        atm->getFragment()->AddAtom(atm);
+        atm->getSegment()->AddAtom(atm);
+        atm->getMolecule()->AddAtom(atm);
+
+        atm->setResnr(rec.resnr);
+        atm->setResname(strings[rec.resname]);
+    }
+
+    const SnapPair *pairs = Section<SnapPair>(base, size, header, SEC_PAIRS);
+    for (int64_t i = 0; i < header->count[SEC_PAIRS]; ++i) {
+        const SnapPair &rec = pairs[i];
+        QMPair *pair = top.NBList().Add(top.getSegment(rec.seg1),
+                                        top.getSegment(rec.seg2));
+        pair->setIsPathCarrier(rec.has_e != 0, -1);
+        pair->setIsPathCarrier(rec.has_h != 0, +1);
+        pair->setLambdaO(rec.lambdaO[0], -1);
+        pair->setLambdaO(rec.lambdaO[1], +1);
+        pair->setRate12(rec.rates[0], -1);
+        pair->setRate21(rec.rates[1], -1);
+        pair->setRate12(rec.rates[2], +1);
+        pair->setRate21(rec.rates[3], +1);
+        pair->setJeff2(rec.Jeff2[0], -1);
+        pair->setJeff2(rec.Jeff2[1], +1);
+        pair->setType(rec.type);
+    }
+
+    const int32_t *superx = Section<int32_t>(base, size, header,
+        SEC_SUPEREXCHANGE);
+    for (int64_t i = 0; i < header->count[SEC_SUPEREXCHANGE]; ++i) {
+        top.NBList().AddSuperExchangeType(strings[superx[i]]);
+    }
+
+    return true;
+}
+
+
+}}
@@ -9,6 +9,7 @@ namespace votca { namespace ctp {
 
     
 XInductor::~XInductor() {
+    this->ReturnSubthreads();
     vector<InduWorker*>::iterator wit;
     for (wit = _indus.begin(); wit != _indus.end(); ++wit) {
         delete *wit;
@@ -118,8 +119,10 @@ void XInductor::Evaluate(XJob *job) {
     else               this->EnergyStatic(job);
     boost::timer::cpu_times t2 = cpu_t.elapsed();
     
-    double t_indu = (t1.wall - t0.wall)/1e9/60.;
-    double t_ener = (t2.wall - t1.wall)/1e9/60.;
+    _t_indu = (t1.wall - t0.wall)/1e9;
+    _t_ener = (t2.wall - t1.wall)/1e9;
+    double t_indu = _t_indu/60.;
+    double t_ener = _t_ener/60.;
     CTP_LOG(logINFO,*_log) << (format("  o Total:     %1$1.2f min")
         % (t_ener+t_indu)) << flush;
     CTP_LOG(logINFO,*_log) << (format("  o Induction: %1$1.2f min")
@@ -645,6 +648,7 @@ double XInductor::Energy(XJob *job) {
     // =============================================================== //
     
 
+    this->ClaimSubthreads();
     for (int id = 0; id < this->_subthreads; ++id) {
         _indus[id]->SetSwitch(0);
     }
@@ -683,6 +687,7 @@ double XInductor::Energy(XJob *job) {
     }
 
     this->ClearTodoTable(); 
+    this->ReturnSubthreads();
 
 
     // +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ //
@@ -1144,7 +1149,8 @@ double XInductor::EnergyStatic(XJob *job) {
 
 XInductor::XInductor(Topology *top, Property *opt, 
                      string sfx, int nst, bool mav)
-                  : _subthreads(nst), _maverick(mav) {
+                  : _subthreads(nst), _maverick(mav), _pool(NULL), 
+                    _claimed(0), _t_indu(0.0), _t_ener(0.0) {
     
     string key = sfx + ".tholemodel";
 
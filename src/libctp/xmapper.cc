@@ -1,9 +1,21 @@
 #include <votca/ctp/xmapper.h>
+#include <boost/lexical_cast.hpp>
 
 
 namespace votca { namespace ctp {
 
 
+// Shared environments are keyed by kind + foreground segment ids
+static string ENV_KEY(const string &kind, XJob *job) {
+    string key = kind;
+    for (unsigned int i = 0; i < job->getSegments().size(); ++i) {
+        key += " " + boost::lexical_cast<string>(
+            job->getSegments()[i]->getId());
+    }
+    return key;
+}
+
+
 void XMpsMap::GenerateMap(string xml_file, 
                           string alloc_table, 
                           Topology *top) {
@@ -923,56 +935,74 @@ void XMpsMap::Gen_FGC_FGN_BGN(Topology *top, XJob *job, QMThread *thread) {
     vector<Segment*> segs_bgN;
     vector<Segment*>::iterator sit;
     
-    // PARTITION SEGMENTS ONTO BACKGROUND + FOREGROUND
-    segs_fgC.reserve(job->getSegments().size());
-    segs_fgN.reserve(job->getSegments().size());
-    segs_bgN.reserve(top->Segments().size()-job->getSegments().size());
-    for (sit = top->Segments().begin();
-         sit < top->Segments().end();
-         ++sit) {        
-        Segment *seg = *sit;        
+    // NEUTRAL FOREGROUND + BACKGROUND: COPY IF SHARED & ALREADY MAPPED
+    XEnvPtr env;
+    bool do_map = true;
+    if (_env_capacity > 0) env = this->RequestEnv(ENV_KEY("FGN_BGN", job), do_map);
+    XEnvGuard env_guard(this, env, do_map);
+    if (!do_map) {
+        segs_fgN = env->segs_inner;
+        segs_bgN = env->segs_outer;
+        this->CopyPolarSegs(env->inner, fgN);
+        this->CopyPolarSegs(env->outer, bgN);
+    }
+    else {
+        // PARTITION SEGMENTS ONTO BACKGROUND + FOREGROUND
+        segs_fgN.reserve(job->getSegments().size());
+        segs_bgN.reserve(top->Segments().size()-job->getSegments().size());
+        for (sit = top->Segments().begin();
+             sit < top->Segments().end();
+             ++sit) {        
+            Segment *seg = *sit;        
+            // Foreground
+            if (job->isInCenter(seg->getId())) {
+                segs_fgN.push_back(seg);
+            }
+            // Background
+            else {
+                segs_bgN.push_back(seg);
+            }        
+        }
+        
+        // CREATE POLAR SITES FOR NEUTRAL FOREGROUND + BACKGROUND
         // Foreground
-        if (job->isInCenter(seg->getId())) {
-            segs_fgN.push_back(seg);
-            segs_fgC.push_back(seg);
+        bool only_active_sites = false;
+        fgN.reserve(segs_fgN.size());
+        for (unsigned int i = 0; i < job->getSegments().size(); ++i) {        
+            Segment *seg = job->getSegments()[i];
+            // Neutral => look up mps file
+            string mps_N = _segId_mpsFile_n[seg->getId()];
+            vector<APolarSite*> psites_raw_N  = _mpsFile_pSites[mps_N];
+            PolarSeg *psegN
+                = this->MapPolSitesToSeg(psites_raw_N, seg, only_active_sites);
+            fgN.push_back(psegN);
         }
         // Background
-        else {
-            segs_bgN.push_back(seg);
-        }        
+        only_active_sites = true;
+        bgN.reserve(segs_bgN.size());
+        for (sit = segs_bgN.begin(); sit < segs_bgN.end(); ++sit) {
+            Segment *seg = *sit;
+            // Look up appropriate set of polar sites
+            string mps = _segId_mpsFile_n[seg->getId()];
+            vector<APolarSite*> psites_raw  = _mpsFile_pSites[mps];
+            PolarSeg *psegN = this->MapPolSitesToSeg(psites_raw, seg);
+            bgN.push_back(psegN);        
+        }
+        if (env) this->FillEnv(env, fgN, bgN, segs_fgN, segs_bgN);
     }
     
-    // CREATE POLAR SITES FOR FOREGROUND + BACKGROUND
-    // Foreground
+    // CHARGED FOREGROUND => MPS-FILES FROM JOB
     bool only_active_sites = false;
+    segs_fgC = segs_fgN;
     fgC.reserve(segs_fgC.size());
-    fgN.reserve(segs_fgN.size());
     for (unsigned int i = 0; i < job->getSegments().size(); ++i) {        
         Segment *seg = job->getSegments()[i];
-        // Charged => mps-file from job
         string mps_C = job->getSegMps()[i];
         vector<APolarSite*> psites_raw_C 
             = this->GetOrCreateRawSites(mps_C,thread);
         PolarSeg *psegC 
             = this->MapPolSitesToSeg(psites_raw_C, seg, only_active_sites);        
         fgC.push_back(psegC);
-        // Neutral => look up mps file
-        string mps_N = _segId_mpsFile_n[seg->getId()];
-        vector<APolarSite*> psites_raw_N  = _mpsFile_pSites[mps_N];
-        PolarSeg *psegN
-            = this->MapPolSitesToSeg(psites_raw_N, seg, only_active_sites);
-        fgN.push_back(psegN);
-    }
-    // Background
-    only_active_sites = true;
-    bgN.reserve(segs_bgN.size());
-    for (sit = segs_bgN.begin(); sit < segs_bgN.end(); ++sit) {
-        Segment *seg = *sit;
-        // Look up appropriate set of polar sites
-        string mps = _segId_mpsFile_n[seg->getId()];
-        vector<APolarSite*> psites_raw  = _mpsFile_pSites[mps];
-        PolarSeg *psegN = this->MapPolSitesToSeg(psites_raw, seg);
-        bgN.push_back(psegN);        
     }
     
     // PROPAGATE SHELLS TO POLAR TOPOLOGY
@@ -993,19 +1023,38 @@ void XMpsMap::Gen_FGC_FGN_BGN(Topology *top, XJob *job, QMThread *thread) {
 void XMpsMap::Gen_FGC_Load_FGN_BGN(Topology *top, XJob *job, string archfile, 
     QMThread *thread) {
     
-    // LOAD BACKGROUND POLARIZATION STATE
-    PolarTop bgp_ptop = PolarTop(top);
-    bgp_ptop.LoadFromDrive(archfile);
-    
-    // SANITY CHECKS I
-    if (bgp_ptop.QM0().size() || bgp_ptop.MM1().size() || bgp_ptop.MM2().size()
-        || bgp_ptop.FGC().size() || bgp_ptop.FGN().size()) {
-        cout << endl;
-        cout << "ERROR The polar topology from '" << archfile 
-            << "' contains more than just background. ";
-        cout << endl;
-        throw std::runtime_error
-            ("Sanity checks I in XMpsMap::Gen_FGC_Load_FGN_BGN failed.");
+    // LOAD BACKGROUND POLARIZATION STATE (ONCE IF SHARED)
+    vector<PolarSeg*> bgP;
+    XEnvPtr env;
+    bool do_map = true;
+    if (_env_capacity > 0) env = this->RequestEnv("ARCH " + archfile, do_map);
+    XEnvGuard env_guard(this, env, do_map);
+    if (!do_map) {
+        this->CopyPolarSegs(env->outer, bgP);
+    }
+    else {
+        PolarTop bgp_ptop = PolarTop(top);
+        bgp_ptop.LoadFromDrive(archfile);
+        
+        // SANITY CHECKS I
+        if (bgp_ptop.QM0().size() || bgp_ptop.MM1().size() 
+            || bgp_ptop.MM2().size() || bgp_ptop.FGC().size() 
+            || bgp_ptop.FGN().size()) {
+            cout << endl;
+            cout << "ERROR The polar topology from '" << archfile 
+                << "' contains more than just background. ";
+            cout << endl;
+            throw std::runtime_error
+                ("Sanity checks I in XMpsMap::Gen_FGC_Load_FGN_BGN failed.");
+        }
+        bgP = bgp_ptop.BGN();
+        // Remember to remove ownership from temporary bgp_ptop
+        bgp_ptop.RemoveAllOwnership();
+        if (env) {
+            vector<PolarSeg*> no_segs;
+            vector<Segment*> no_segs_top;
+            this->FillEnv(env, no_segs, bgP, no_segs_top, no_segs_top);
+        }
     }
     
     // DECLARE TARGET CONTAINERS
@@ -1053,7 +1102,7 @@ void XMpsMap::Gen_FGC_Load_FGN_BGN(Topology *top, XJob *job, string archfile,
     }
     
     // DIVIDE POLAR SEGMENTS FROM RESURRECTED BACKGROUND ONTO FGN, BGN
-    for (psit = bgp_ptop.BGN().begin(); psit < bgp_ptop.BGN().end(); ++psit) {
+    for (psit = bgP.begin(); psit < bgP.end(); ++psit) {
         // Move to (neutral) foreground?
         if (job->isInCenter((*psit)->getId())) {
             fgN.push_back(*psit);
@@ -1067,7 +1116,7 @@ void XMpsMap::Gen_FGC_Load_FGN_BGN(Topology *top, XJob *job, string archfile,
     // SANITY CHECKS II
     if ((fgN.size() != fgC.size())
         || (fgN.size() + bgN.size() != top->Segments().size())
-        || (bgp_ptop.BGN().size() != top->Segments().size())) {
+        || (bgP.size() != top->Segments().size())) {
         cout << endl;
         cout << "ERROR Is the background binary compatible with this system? ";
         cout << "(archive = '" << archfile << "')";
@@ -1083,8 +1132,6 @@ void XMpsMap::Gen_FGC_Load_FGN_BGN(Topology *top, XJob *job, string archfile,
     new_ptop->setSegsFGC(segs_fgC);
     new_ptop->setSegsFGN(segs_fgN);
     new_ptop->setSegsBGN(segs_bgN);
-    // Remember to remove ownership from temporary bgp_ptop
-    bgp_ptop.RemoveAllOwnership();
     // Center polar topology
     vec center = job->Center();
     new_ptop->CenterAround(center);
@@ -1110,6 +1157,16 @@ void XMpsMap::Gen_QM_MM1_MM2(Topology *top, XJob *job, double co1, double co2, Q
     vector<Segment*> segs_mm2;    
     vector<Segment*> ::iterator sit;
     
+    // MM1 + MM2 SHELLS: COPY IF SHARED & ALREADY MAPPED
+    XEnvPtr env;
+    bool do_map = true;
+    if (_env_capacity > 0) {
+        string kind = "MM1_MM2 " + boost::lexical_cast<string>(co1) + " " 
+            + boost::lexical_cast<string>(co2);
+        env = this->RequestEnv(ENV_KEY(kind, job), do_map);
+    }
+    XEnvGuard env_guard(this, env, do_map);
+    
     // PARTITION SEGMENTS ONTO SHELLS    
     for (sit = top->Segments().begin();
          sit < top->Segments().end();
@@ -1121,6 +1178,10 @@ void XMpsMap::Gen_QM_MM1_MM2(Topology *top, XJob *job, double co1, double co2, Q
         if (job->isInCenter(seg->getId())) {
             segs_qm0.push_back(seg);
         } 
+        // SHARED SHELLS
+        else if (!do_map) {
+            ;
+        }
         // MM1 SHELL
         else if (job->isWithinDist(seg->getPos(),co1,top)) {
             segs_mm1.push_back(seg);
@@ -1147,29 +1208,39 @@ void XMpsMap::Gen_QM_MM1_MM2(Topology *top, XJob *job, double co1, double co2, Q
                 = this->MapPolSitesToSeg(psites_raw, seg, only_active_sites);        
         qm0.push_back(psites_mapped);        
     }
-    // ... MM1 SHELL
-    only_active_sites = true;
-    mm1.reserve(segs_mm1.size());
-    for (sit = segs_mm1.begin(); sit < segs_mm1.end(); ++sit) {
-        Segment *seg = *sit;
-        // Look up appropriate set of polar sites
-        string mps = _segId_mpsFile_n[seg->getId()];
-        vector<APolarSite*> psites_raw  = _mpsFile_pSites[mps];
-        PolarSeg *psites_mapped
-                = this->MapPolSitesToSeg(psites_raw, seg, only_active_sites);
-        mm1.push_back(psites_mapped);        
+    // ... MM1 + MM2 SHELLS FROM SHARED ENVIRONMENT
+    if (!do_map) {
+        segs_mm1 = env->segs_inner;
+        segs_mm2 = env->segs_outer;
+        this->CopyPolarSegs(env->inner, mm1);
+        this->CopyPolarSegs(env->outer, mm2);
     }
-    // ... MM2 SHELL
-    only_active_sites = true;
-    mm2.reserve(segs_mm2.size());
-    for (sit = segs_mm2.begin(); sit < segs_mm2.end(); ++sit) {
-        Segment *seg = *sit;
-        // Look up appropriate set of polar sites
-        string mps = _segId_mpsFile_n[seg->getId()];
-        vector<APolarSite*> psites_raw  = _mpsFile_pSites[mps];
-        PolarSeg *psites_mapped
-                = this->MapPolSitesToSeg(psites_raw, seg, only_active_sites);
-        mm2.push_back(psites_mapped);
+    else {
+        // ... MM1 SHELL
+        only_active_sites = true;
+        mm1.reserve(segs_mm1.size());
+        for (sit = segs_mm1.begin(); sit < segs_mm1.end(); ++sit) {
+            Segment *seg = *sit;
+            // Look up appropriate set of polar sites
+            string mps = _segId_mpsFile_n[seg->getId()];
+            vector<APolarSite*> psites_raw  = _mpsFile_pSites[mps];
+            PolarSeg *psites_mapped
+                    = this->MapPolSitesToSeg(psites_raw, seg, only_active_sites);
+            mm1.push_back(psites_mapped);        
+        }
+        // ... MM2 SHELL
+        only_active_sites = true;
+        mm2.reserve(segs_mm2.size());
+        for (sit = segs_mm2.begin(); sit < segs_mm2.end(); ++sit) {
+            Segment *seg = *sit;
+            // Look up appropriate set of polar sites
+            string mps = _segId_mpsFile_n[seg->getId()];
+            vector<APolarSite*> psites_raw  = _mpsFile_pSites[mps];
+            PolarSeg *psites_mapped
+                    = this->MapPolSitesToSeg(psites_raw, seg, only_active_sites);
+            mm2.push_back(psites_mapped);
+        }
+        if (env) this->FillEnv(env, mm1, mm2, segs_mm1, segs_mm2);
     }
     
     // PROPAGATE SHELLS TO POLAR TOPOLOGY
@@ -1188,4 +1259,84 @@ void XMpsMap::Gen_QM_MM1_MM2(Topology *top, XJob *job, double co1, double co2, Q
 }
 
 
+XMpsMap::XEnv::~XEnv() {
+    vector<PolarSeg*>::iterator psit;
+    for (psit = inner.begin(); psit < inner.end(); ++psit) delete *psit;
+    for (psit = outer.begin(); psit < outer.end(); ++psit) delete *psit;
+}
+
+
+XMpsMap::XEnvPtr XMpsMap::RequestEnv(const string &key, bool &do_map) {
+    // Returns the environment under key. do_map = true: not there yet, the
+    // caller maps it and hands it over via ::FillEnv. Otherwise waits until
+    // the environment has been mapped (possibly by another thread). If that
+    // mapping failed, do_map = true without environment: map privately.
+    _lockThread.Lock();
+    XEnvPtr env;
+    map<string, XEnvPtr>::iterator eit = _env.find(key);
+    if (eit != _env.end()) {
+        env = eit->second;
+        _env_lru.remove(key);
+        do_map = false;
+    }
+    else {
+        env = XEnvPtr(new XEnv(key));
+        env->mapped.Lock();
+        _env[key] = env;
+        do_map = true;
+    }
+    _env_lru.push_front(key);
+    // Evicted environments live on as long as a job still copies from them
+    while (int(_env_lru.size()) > _env_capacity) {
+        _env.erase(_env_lru.back());
+        _env_lru.pop_back();
+    }
+    _lockThread.Unlock();
+    
+    if (!do_map) {
+        env->mapped.Lock();
+        env->mapped.Unlock();
+        if (!env->ready) {
+            env.reset();
+            do_map = true;
+        }
+    }
+    return env;
+}
+
+
+void XMpsMap::FillEnv(XEnvPtr env, vector<PolarSeg*> &inner, 
+    vector<PolarSeg*> &outer, vector<Segment*> &segs_inner, 
+    vector<Segment*> &segs_outer) {
+    // Stores pristine copies: the originals go to the job and get polarized
+    this->CopyPolarSegs(inner, env->inner);
+    this->CopyPolarSegs(outer, env->outer);
+    env->segs_inner = segs_inner;
+    env->segs_outer = segs_outer;
+    env->ready = true;
+    env->mapped.Unlock();
+}
+
+
+void XMpsMap::DropEnv(XEnvPtr env) {
+    // Mapping failed: the next job with this key starts over
+    _lockThread.Lock();
+    map<string, XEnvPtr>::iterator eit = _env.find(env->key);
+    if (eit != _env.end() && eit->second == env) {
+        _env.erase(eit);
+        _env_lru.remove(env->key);
+    }
+    _lockThread.Unlock();
+    env->mapped.Unlock();
+}
+
+
+void XMpsMap::CopyPolarSegs(vector<PolarSeg*> &from, vector<PolarSeg*> &to) {
+    to.reserve(to.size() + from.size());
+    for (unsigned int i = 0; i < from.size(); ++i) {
+        to.push_back(new PolarSeg(from[i], false));
+    }
+}
+
+
 }}